@@ -0,0 +1,66 @@
+/**
+ * Command-line tool that runs inference on a batch of data files in parallel and prints the result for each file as a
+ * line of JSON (see `writeResultJson`).
+ *
+ * Usage: batch_infer [-j <threads>] [-c <rows per chunk>] [-s <schema cache directory>] <file or directory>...
+ *
+ * Directories are expanded to the regular files that they contain (not recursively). With a schema cache directory,
+ * the results of files that haven't changed since they were last classified are read from the cache (see
+ * `SchemaCache`).
+ *
+ * @author Duncan Mazza
+ */
+
+#include "tabulated_data_inference.h"
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+static void printUsage() {
+    cerr << "Usage: batch_infer [-j <threads>] [-c <rows per chunk>] [-s <schema cache directory>] "
+            "<file or directory>..." << endl;
+}
+
+
+int main(int argc, char **argv) {
+    size_t numThreads = 0;
+    size_t chunkRows = 65536;
+    unique_ptr<SchemaCache> cache;
+    vector<string> paths;
+    for (int argIdx = 1; argIdx < argc; argIdx++) {
+        if (!strcmp(argv[argIdx], "-s") && argIdx + 1 < argc) {
+            cache = make_unique<SchemaCache>(argv[argIdx + 1]);
+            argIdx++;
+        } else if ((!strcmp(argv[argIdx], "-j") || !strcmp(argv[argIdx], "-c")) && argIdx + 1 < argc) {
+            size_t value = strtoul(argv[argIdx + 1], nullptr, 10);
+            (argv[argIdx][1] == 'j' ? numThreads : chunkRows) = value;
+            argIdx++;
+        } else if (argv[argIdx][0] == '-') {
+            printUsage();
+            return 1;
+        } else if (!listDataFiles(argv[argIdx], paths)) {
+            paths.emplace_back(argv[argIdx]);  // Not a directory, so treat it as a file
+        }
+    }
+    if (paths.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    vector<FileInferenceResult> results;
+    classifyFiles(paths, results, numThreads, chunkRows, cache.get());
+
+    int allClassified = 1;
+    for (const auto &result: results) {
+        writeResultJson(result, cout);
+        cout << '\n';
+        allClassified &= result.status;
+    }
+    cout.flush();
+    return allClassified ? 0 : 2;
+}
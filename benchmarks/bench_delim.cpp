@@ -0,0 +1,66 @@
+/**
+ * Benchmarks for counting delimiters, comparing the scalar and vectorized delimiter histograms.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <benchmark/benchmark.h>
+#include "bench_generators.h"
+#include <delim_helpers.h>
+#include <tabulated_data_inference.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+static void BM_DelimHistogramScalar(benchmark::State &state) {
+    vector<string> lines;
+    makeWideTabLines(1000, (size_t) state.range(0), lines);
+    for (auto _: state) {
+        size_t delimCount[NDELIMS] = {0};
+        for (const auto &line: lines) {
+            countDelimsScalar(line.data(), line.size(), delimCount);
+        }
+        benchmark::DoNotOptimize(delimCount);
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * totalBytes(lines)));
+}
+BENCHMARK(BM_DelimHistogramScalar)->Arg(8)->Arg(82)->Arg(512);
+
+
+static void BM_DelimHistogramVectorized(benchmark::State &state) {
+    vector<string> lines;
+    makeWideTabLines(1000, (size_t) state.range(0), lines);
+    for (auto _: state) {
+        size_t delimCount[NDELIMS] = {0};
+        for (const auto &line: lines) {
+            countDelims(line.data(), line.size(), delimCount);
+        }
+        benchmark::DoNotOptimize(delimCount);
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * totalBytes(lines)));
+}
+BENCHMARK(BM_DelimHistogramVectorized)->Arg(8)->Arg(82)->Arg(512);
+
+
+static void BM_GetDelimLongSems(benchmark::State &state) {
+    const string path = string(BENCHMARKS_REPO_DIR) + "/tests/test_targets/long_SEMS.dat";
+    MappedFile file;
+    if (!file.open(path)) {
+        state.SkipWithError(("Could not open " + path).c_str());
+        return;
+    }
+    vector<string_view> lines;
+    getBufferLines(file.view(), lines);
+
+    // `getDelim` stops reading lines once only one delimiter is consistent, so count the lines it actually reads
+    InferenceStats stats;
+    getDelim(lines, &stats);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(getDelim(lines));
+    }
+    state.SetBytesProcessed((int64_t) (state.iterations() * stats.bytesScanned[IP_DELIM]));
+    state.counters["lines_scanned"] = (double) stats.linesScanned[IP_DELIM];
+}
+BENCHMARK(BM_GetDelimLongSems);
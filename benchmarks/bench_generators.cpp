@@ -0,0 +1,108 @@
+/**
+ * Definitions for the generators of synthetic delimited data used by the benchmarks.
+ *
+ * @author Duncan Mazza
+ */
+
+#include "bench_generators.h"
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+
+static string makeTimestamp(size_t minutes, bool iso) {
+    // Timestamps count up a minute at a time from 2/9/2022 00:00, as in the ACSM data (days wrap within the month)
+    const size_t day = 1 + (9 + minutes / (24 * 60)) % 28;
+    const size_t hour = minutes / 60 % 24;
+    const size_t minute = minutes % 60;
+    char buffer[32];
+    if (iso) {
+        snprintf(buffer, sizeof(buffer), "2022-02-%02zuT%02zu:%02zu:00", day, hour, minute);
+    } else {
+        snprintf(buffer, sizeof(buffer), "2/%zu/2022 %zu:%02zu", day, hour, minute);
+    }
+    return buffer;
+}
+
+
+void makeWideTabLines(size_t numRows, size_t numColumns, vector<string> &lines) {
+    for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
+        string line = "181021\t16:02:53";
+        for (size_t columnIdx = 2; columnIdx < numColumns; columnIdx++) {
+            line += '\t';
+            line += to_string((double) (rowIdx * numColumns + columnIdx) * 0.731);
+        }
+        lines.push_back(line);
+    }
+}
+
+
+void makeDatasetLines(BenchDataset dataset, size_t numRows, vector<string> &lines) {
+    mt19937 generator(0);
+    uniform_real_distribution<double> realDist(-100, 100);
+
+    switch (dataset) {
+        case BD_TALL_NARROW:
+            lines.emplace_back("id,value,flag");
+            for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
+                lines.push_back(to_string(rowIdx) + ',' + to_string(realDist(generator)) + ',' +
+                                to_string(generator() % 2));
+            }
+            break;
+        case BD_WIDE: {
+            string header = "date\ttime";
+            for (size_t columnIdx = 2; columnIdx < 82; columnIdx++) {
+                header += "\tch" + to_string(columnIdx);
+            }
+            lines.push_back(header);
+            makeWideTabLines(numRows, 82, lines);
+            break;
+        }
+        case BD_DATETIME:
+            lines.emplace_back("local_time,utc_time,iso_time,time,value");
+            for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
+                char time[16];
+                snprintf(time, sizeof(time), "%02zu:%02zu:%02zu", rowIdx / 3600 % 24, rowIdx / 60 % 60, rowIdx % 60);
+                lines.push_back(makeTimestamp(rowIdx, false) + ',' + makeTimestamp(rowIdx + 300, false) + ',' +
+                                makeTimestamp(rowIdx, true) + ',' + time + ',' + to_string(realDist(generator)));
+            }
+            break;
+        case BD_METADATA_PREFIXED:
+            for (const char *metadataLine: {"Xfoil polar. Reynolds number fixed. Mach  number fixed",
+                                            "Polar key,xf-naca2408-il-50000", "Airfoil,naca2408-il",
+                                            "Reynolds number,50000", "Ncrit,9", "Mach,0", "Max Cl/Cd,37.4214",
+                                            "Max Cl/Cd alpha,5.5", "", ""}) {
+                lines.emplace_back(metadataLine);
+            }
+            lines.emplace_back("Alpha,Cl,Cd,Cdp,Cm,Top_Xtr,Bot_Xtr");
+            for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
+                string line = to_string(-9.25 + 0.25 * (double) rowIdx);
+                for (int columnIdx = 1; columnIdx < 7; columnIdx++) {
+                    line += ',' + to_string(realDist(generator) / 100);
+                }
+                lines.push_back(line);
+            }
+            break;
+        case BD_MIXED: {
+            const char *const names[]{"alpha", "beta", "gamma", "delta", "n/a", "\"Smith\""};
+            lines.emplace_back("name,count,ratio,sci,date,flags,comment");
+            for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
+                char sci[32];
+                snprintf(sci, sizeof(sci), "%.3E", realDist(generator) * 1e-9);
+                lines.push_back(string(names[generator() % 6]) + ',' + to_string(generator() % 100000) + ',' +
+                                to_string(realDist(generator)) + ',' + sci + ",2022-02-" +
+                                to_string(10 + generator() % 18) + ',' + (generator() % 2 ? "0110" : "1001") +
+                                ",\"note_" + to_string(rowIdx) + '"');
+            }
+            break;
+        }
+    }
+}
+
+
+size_t totalBytes(const vector<string> &lines) {
+    size_t numBytes = 0;
+    for (const auto &line: lines) numBytes += line.size();
+    return numBytes;
+}
@@ -0,0 +1,54 @@
+/**
+ * Headers for the generators of synthetic delimited data used by the benchmarks.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_BENCH_GENERATORS_H
+#define DELIMITED_FILE_INFERENCE_BENCH_GENERATORS_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Kinds of synthetic data, each modeled after a kind of file that the library is used on.
+ */
+typedef enum {
+    BD_TALL_NARROW,  // Few comma-delimited numeric and boolean columns and many rows
+    BD_WIDE,  // Many tab-delimited columns of floating point numbers (like long_SEMS.dat)
+    BD_DATETIME,  // Comma-delimited date, time, and datetime columns (like the timestamps of acsm_shortened.csv)
+    BD_METADATA_PREFIXED,  // Comma-delimited numeric columns after lines of metadata (like xf-naca2408-il-50000.csv)
+    BD_MIXED,  // Comma-delimited columns of every classification, including arbitrary (and quoted) strings
+} BenchDataset;
+const int NUM_BD = 5;
+
+const char *const BenchDatasetNames[]{
+        "tall_narrow",
+        "wide",
+        "datetime",
+        "metadata_prefixed",
+        "mixed",
+};
+
+
+/**
+ * Generate the lines of a data file, starting with any metadata lines and the header. Generation is deterministic.
+ *
+ * @param dataset The kind of data to generate
+ * @param numRows Number of rows of data (not counting the header and any metadata)
+ * @param lines Vector to which the lines are appended
+ */
+void makeDatasetLines(BenchDataset dataset, size_t numRows, vector<string> &lines);
+
+/**
+ * Generate lines of many tab-delimited columns of floating point numbers (without a header).
+ */
+void makeWideTabLines(size_t numRows, size_t numColumns, vector<string> &lines);
+
+size_t totalBytes(const vector<string> &lines);
+
+#endif //DELIMITED_FILE_INFERENCE_BENCH_GENERATORS_H
@@ -0,0 +1,11 @@
+/**
+ * Entry point for the benchmarks.
+ *
+ * @note Unlike the unit tests, the benchmarks don't depend on the CWD: the files in tests/test_targets are found
+ *  through the `BENCHMARKS_REPO_DIR` definition (the repository root, set by benchmarks/CMakeLists.txt).
+ * @author Duncan Mazza
+ */
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,64 @@
+/**
+ * Benchmarks for the per-call cost of obtaining a parser, comparing compiling the grammar on every call with leasing a
+ * parser from a pool.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <benchmark/benchmark.h>
+#include <tabulated_data_inference.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Rows of a small file, for which obtaining a parser is most of the work.
+ */
+static const vector<vector<string>> SMALL_FILE_ROWS{
+        {"date",     "time",     "count", "ratio"},
+        {"20181021", "16:02:53", "1",     "0.5"},
+        {"20181021", "16:02:54", "12",    "0.25"},
+        {"20181021", "16:02:55", "123",   "0.125"},
+};
+
+
+static void BM_ParserCompile(benchmark::State &state) {
+    for (auto _: state) {
+        auto parser = MpcParserTWrapper();
+        benchmark::DoNotOptimize(parser.getParserPtr());
+    }
+}
+BENCHMARK(BM_ParserCompile);
+
+
+static void BM_ParserPoolAcquire(benchmark::State &state) {
+    MpcParserPool pool;
+    for (auto _: state) {
+        auto lease = pool.acquire();
+        benchmark::DoNotOptimize(lease.get().getParserPtr());
+    }
+}
+BENCHMARK(BM_ParserPoolAcquire)->Threads(1)->Threads(4);
+
+
+static void BM_ClassifySmallFileCompilingParser(benchmark::State &state) {
+    for (auto _: state) {
+        auto parser = MpcParserTWrapper();
+        vector<tuple<string, FieldCls>> classifications;
+        classifyColumns(SMALL_FILE_ROWS, classifications, parser);
+        benchmark::DoNotOptimize(classifications.data());
+    }
+}
+BENCHMARK(BM_ClassifySmallFileCompilingParser);
+
+
+static void BM_ClassifySmallFileAutoSetup(benchmark::State &state) {
+    for (auto _: state) {
+        vector<tuple<string, FieldCls>> classifications;
+        classifyColumnsAutoSetup(SMALL_FILE_ROWS, classifications);
+        benchmark::DoNotOptimize(classifications.data());
+    }
+}
+BENCHMARK(BM_ClassifySmallFileAutoSetup);
@@ -0,0 +1,173 @@
+/**
+ * Benchmarks for each stage of inference (delimiter detection, field splitting, and column classification) over each
+ * kind of synthetic data.
+ *
+ * @note Every benchmark reports bytes/s, rows/s, and fields/s of the data that the benchmarked call reads (including
+ *  any metadata lines) so that the stages can be compared with each other. `getDelim` stops at the first line that no
+ *  delimiter is consistent with, so only the lines it reads are counted (as bytes/s and rows/s). `classifyColumns`
+ *  stops reading rows once every column is saturated (unless sketches are collected), so only the fields it classifies
+ *  are counted (as fields/s).
+ * @author Duncan Mazza
+ */
+
+#include <benchmark/benchmark.h>
+#include "bench_generators.h"
+#include <tabulated_data_inference.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+const size_t BENCH_NUM_ROWS = 20000;
+
+
+/**
+ * Synthetic data and its size, generated once per dataset and shared by all benchmarks.
+ */
+struct BenchData {
+    vector<string> lines;
+    size_t numBytes;
+    size_t numFields;
+    tuple<char, size_t> delim;
+    vector<vector<string>> rows;
+};
+
+static const BenchData &getBenchData(int dataset) {
+    static BenchData allData[NUM_BD];
+    static bool generated[NUM_BD] = {false};
+
+    BenchData &data = allData[dataset];
+    if (!generated[dataset]) {
+        // Keep wide files to roughly the same number of bytes as the others
+        makeDatasetLines((BenchDataset) dataset, dataset == BD_WIDE ? BENCH_NUM_ROWS / 16 : BENCH_NUM_ROWS, data.lines);
+        data.numBytes = totalBytes(data.lines);
+        data.delim = getDelim(data.lines);
+        getFields(data.lines, get<0>(data.delim), data.rows, get<1>(data.delim));
+        data.numFields = 0;
+        for (const auto &row: data.rows) data.numFields += row.size();
+        generated[dataset] = true;
+    }
+    return data;
+}
+
+/**
+ * Report the throughput of a call that reads the given numbers of bytes, rows, and fields on each iteration (where 0
+ * leaves the counter out).
+ */
+static void setThroughputCounters(benchmark::State &state, size_t numBytes, size_t numRows, size_t numFields) {
+    state.SetLabel(BenchDatasetNames[state.range(0)]);
+    if (numBytes) {
+        state.SetBytesProcessed((int64_t) (state.iterations() * numBytes));
+    }
+    if (numRows) {
+        state.counters["rows/s"] = benchmark::Counter((double) (state.iterations() * numRows),
+                                                      benchmark::Counter::kIsRate);
+    }
+    if (numFields) {
+        state.counters["fields/s"] = benchmark::Counter((double) (state.iterations() * numFields),
+                                                        benchmark::Counter::kIsRate);
+    }
+}
+
+/**
+ * Report the throughput of a call that reads all of the data on each iteration.
+ */
+static void setThroughputCounters(benchmark::State &state, const BenchData &data) {
+    setThroughputCounters(state, data.numBytes, data.rows.size(), data.numFields);
+}
+
+
+static void BM_GetDelim(benchmark::State &state) {
+    const BenchData &data = getBenchData((int) state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(getDelim(data.lines));
+    }
+    InferenceStats stats;
+    getDelim(data.lines, &stats);
+    setThroughputCounters(state, stats.bytesScanned[IP_DELIM], stats.linesScanned[IP_DELIM], 0);
+}
+BENCHMARK(BM_GetDelim)->DenseRange(0, NUM_BD - 1);
+
+
+static void BM_GetFields(benchmark::State &state) {
+    const BenchData &data = getBenchData((int) state.range(0));
+    for (auto _: state) {
+        vector<vector<string>> rows;
+        getFields(data.lines, get<0>(data.delim), rows, get<1>(data.delim));
+        benchmark::DoNotOptimize(rows.data());
+    }
+    setThroughputCounters(state, data);
+}
+BENCHMARK(BM_GetFields)->DenseRange(0, NUM_BD - 1);
+
+
+static void BM_GetFieldsColumnar(benchmark::State &state) {
+    const BenchData &data = getBenchData((int) state.range(0));
+    ColumnarFields fields;
+    for (auto _: state) {
+        getFields(data.lines, get<0>(data.delim), fields, get<1>(data.delim));
+        benchmark::DoNotOptimize(fields.getNumRows());
+    }
+    setThroughputCounters(state, data);
+}
+BENCHMARK(BM_GetFieldsColumnar)->DenseRange(0, NUM_BD - 1);
+
+
+/**
+ * Arguments are the dataset and the `ClassificationEngine`.
+ */
+static void BM_ClassifyColumns(benchmark::State &state) {
+    const BenchData &data = getBenchData((int) state.range(0));
+    auto parser = MpcParserTWrapper();
+    for (auto _: state) {
+        vector<tuple<string, FieldCls>> classifications;
+        classifyColumns(data.rows, classifications, parser, nullptr, (ClassificationEngine) state.range(1));
+        benchmark::DoNotOptimize(classifications.data());
+    }
+    InferenceStats stats;
+    vector<tuple<string, FieldCls>> classifications;
+    classifyColumns(data.rows, classifications, parser, nullptr, (ClassificationEngine) state.range(1), 0, CK_VALUE,
+                    &stats);
+    setThroughputCounters(state, 0, 0, stats.numFieldsClassified);
+}
+BENCHMARK(BM_ClassifyColumns)->ArgsProduct({benchmark::CreateDenseRange(0, NUM_BD - 1, 1), {CE_MPC, CE_DFA}});
+
+
+/**
+ * Arguments are the dataset and whether the per-column caches are keyed by value (0) or by shape (1).
+ */
+static void BM_ClassifyColumnsCached(benchmark::State &state) {
+    const BenchData &data = getBenchData((int) state.range(0));
+    auto parser = MpcParserTWrapper();
+    for (auto _: state) {
+        vector<tuple<string, FieldCls>> classifications;
+        classifyColumns(data.rows, classifications, parser, nullptr, CE_MPC, 256,
+                        state.range(1) ? CK_SHAPE : CK_VALUE);
+        benchmark::DoNotOptimize(classifications.data());
+    }
+    InferenceStats stats;
+    vector<tuple<string, FieldCls>> classifications;
+    classifyColumns(data.rows, classifications, parser, nullptr, CE_MPC, 256, state.range(1) ? CK_SHAPE : CK_VALUE,
+                    &stats);
+    setThroughputCounters(state, 0, 0, stats.numFieldsClassified);
+}
+BENCHMARK(BM_ClassifyColumnsCached)->ArgsProduct({benchmark::CreateDenseRange(0, NUM_BD - 1, 1), {0, 1}});
+
+
+/**
+ * Arguments are the dataset and the `ClassificationEngine`; column sketches are collected in the same pass.
+ */
+static void BM_ClassifyColumnsSketched(benchmark::State &state) {
+    const BenchData &data = getBenchData((int) state.range(0));
+    auto parser = MpcParserTWrapper();
+    for (auto _: state) {
+        vector<tuple<string, FieldCls>> classifications;
+        vector<ColumnSketch> sketches;
+        classifyColumns(data.rows, classifications, parser, nullptr, (ClassificationEngine) state.range(1), 0,
+                        CK_VALUE, nullptr, &sketches);
+        benchmark::DoNotOptimize(sketches.data());
+    }
+    setThroughputCounters(state, data);
+}
+BENCHMARK(BM_ClassifyColumnsSketched)->ArgsProduct({benchmark::CreateDenseRange(0, NUM_BD - 1, 1), {CE_MPC, CE_DFA}});
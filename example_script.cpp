@@ -49,26 +49,29 @@ int main() {
     for (const auto &thisFileLines: filesLines) {
         fileIdx++;
         cout << "Parsing " << fileTargets.at(fileIdx) << endl;
+        InferenceStats stats;
 
         cout << "Finding delimiter..." << endl;
-        auto delimRet = getDelim(thisFileLines);
+        auto delimRet = getDelim(thisFileLines, &stats);
 
         cout << "Finding fields..." << endl;
         vector<vector<string>> fieldRet;
-        int consistentFields = getFields(thisFileLines, get<0>(delimRet), fieldRet, get<1>(delimRet));
+        int consistentFields = getFields(thisFileLines, get<0>(delimRet), fieldRet, get<1>(delimRet), &stats);
         if (!consistentFields) {
             cout << "Could not find a consistent number of fields in " << fileTargets.at(fileIdx) << endl;
         }
 
         cout << "Classifying fields..." << endl;
         vector<tuple<string, FieldCls>> classificationRet;
-        classifyColumns(fieldRet, classificationRet, parser);
+        classifyColumns(fieldRet, classificationRet, parser, nullptr, CE_MPC, 0, CK_VALUE, &stats);
 
         cout << "Data insights for " << fileTargets.at(fileIdx) << ":" << endl;
         for (auto classification: classificationRet) {
             cout << " - " << get<0>(classification) << " (" << FieldClsCorrespondingNames[get<1>(classification)] << ")"
                  << endl;
         }
+        cout << "Statistics for " << fileTargets.at(fileIdx) << ":" << endl;
+        stats.print(cout);
         cout << endl;
     }
     return 0;
@@ -0,0 +1,70 @@
+/**
+ * Headers for fixed-size per-column statistics that are collected in the same pass as column classification.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_COLUMN_SKETCH_H
+#define DELIMITED_FILE_INFERENCE_COLUMN_SKETCH_H
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+using namespace std;
+
+
+const int HLL_PRECISION = 10;
+const size_t HLL_NUM_REGISTERS = (size_t) 1 << HLL_PRECISION;
+
+
+/**
+ * @return Whether a field is one of the usual spellings of a missing value ("NA", "N/A", "NaN", "nan", "NULL", "null",
+ *  "None"). Empty fields are counted separately.
+ */
+bool isNullField(string_view field);
+
+
+/**
+ * Statistics of the fields of one column, whose size doesn't depend on the number of fields: counts of empty and null
+ * fields, the range of the numeric fields, and a HyperLogLog estimate of the number of distinct fields.
+ *
+ * @note Numbers are parsed with `parseInt64Field` and `parseDoubleField`, so the ranges cover the fields that the
+ *  grammar would classify as integers (or as integers and floating point numbers). Fields of other kinds in the same
+ *  column (e.g., null fields of an integer column) are left out of the ranges.
+ * @note The distinct estimate uses 2^10 one-byte registers, for a standard error of about 3%, and is exact enough for
+ *  small columns (linear counting is used while many registers are empty). Sketches of disjoint sets of rows can be
+ *  merged, which gives the sketch of their union.
+ */
+struct ColumnSketch {
+    size_t numFields;
+    size_t numEmpty;
+    size_t numNull;  // Number of fields for which `isNullField` is true
+    size_t numInt64;  // Number of fields that are integers that fit in 64 bits
+    int64_t minInt64;
+    int64_t maxInt64;
+    size_t numDouble;  // Number of fields that are numbers (including integers)
+    double minDouble;
+    double maxDouble;
+    array<uint8_t, HLL_NUM_REGISTERS> hllRegisters;
+
+    ColumnSketch();
+
+    /**
+     * Add a field to the statistics.
+     */
+    void add(string_view field);
+
+    /**
+     * Add the statistics of another sketch (of other rows of the same column).
+     */
+    void merge(const ColumnSketch &other);
+
+    /**
+     * @return The estimated number of distinct fields added.
+     */
+    double getDistinctEstimate() const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_COLUMN_SKETCH_H
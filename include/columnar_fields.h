@@ -0,0 +1,75 @@
+/**
+ * Headers for the column-major storage of the fields of delimited data.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_COLUMNAR_FIELDS_H
+#define DELIMITED_FILE_INFERENCE_COLUMNAR_FIELDS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Fields of delimited data stored column by column in a single contiguous arena, as an alternative to a vector of rows
+ * where each row is a vector of strings.
+ *
+ * @note The fields of each column are stored back to back in row order, and the columns are stored one after another.
+ *  Each field costs only its end offset in the arena (8 bytes) on top of its contents, and the fields of a column can
+ *  be read with a linear scan of the arena.
+ * @note As with the rows given by `getFields`, row 0 contains the column names. The number of columns is the number of
+ *  fields in row 0; fields beyond that in other rows are dropped, and rows with fewer fields are recorded as such (see
+ *  `getNumFields`).
+ */
+class ColumnarFields {
+private:
+    string _arena;
+    vector<uint64_t> _columnStarts;  // Offset in the arena of the first field of each column
+    vector<uint64_t> _fieldEnds;  // Column-major [column][row] offset in the arena just past each field
+    vector<uint32_t> _rowNumFields;  // Number of fields in each row (capped at the number of columns)
+
+    template<typename LineT>
+    int assignImpl(const vector<LineT> &lines, char delim, size_t stopAt);
+public:
+    ColumnarFields();
+
+    /**
+     * Split lines into fields and store them, replacing the current contents. See `getFields`, which this backs.
+     *
+     * @return 1 if a consistent number of fields was found in every non-empty line, 0 if not, and -1 if there are no
+     *  lines.
+     */
+    int assign(const vector<string> &lines, char delim, size_t stopAt = -1);
+    int assign(const vector<string_view> &lines, char delim, size_t stopAt = -1);
+
+    void clear();
+
+    size_t getNumRows() const;
+    size_t getNumColumns() const;
+
+    /**
+     * @param rowIdx Index of the row
+     * @return The number of fields of the row that have a corresponding column.
+     */
+    size_t getNumFields(size_t rowIdx) const;
+
+    /**
+     * @param rowIdx Index of the row
+     * @param columnIdx Index of the column, which must be less than `getNumFields(rowIdx)`
+     * @return A view of the field, which is valid until the contents of this object are changed.
+     */
+    string_view getField(size_t rowIdx, size_t columnIdx) const;
+
+    /**
+     * @return The number of bytes of heap memory used to hold the fields and their offsets.
+     */
+    size_t getStorageBytes() const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_COLUMNAR_FIELDS_H
@@ -25,4 +25,26 @@ DelimFindingState delimFinderStateTrans(DelimFindingState currState, const size_
 
 int get_delim_idx(char delim);
 
+/**
+ * Count the occurrences of each of the characters in `DELIMS` in a string, one character at a time.
+ *
+ * @param str The string to scan (need not be null-terminated)
+ * @param len Length of the string
+ * @param delimCount Array of length `NDELIMS` to which the count of each delimiter is added
+ */
+void countDelimsScalar(const char *str, size_t len, size_t *delimCount);
+
+/**
+ * Count the occurrences of each of the characters in `DELIMS` in a string, 16 (SSE2) or 32 (AVX2) bytes at a time.
+ *
+ * @note The AVX2 implementation is used if the CPU supports it (as determined at runtime); otherwise, the SSE2
+ *  implementation is used, or `countDelimsScalar` on targets without SSE2. The counts are identical to those of
+ *  `countDelimsScalar`.
+ *
+ * @param str The string to scan (need not be null-terminated)
+ * @param len Length of the string
+ * @param delimCount Array of length `NDELIMS` to which the count of each delimiter is added
+ */
+void countDelims(const char *str, size_t len, size_t *delimCount);
+
 #endif //DELIMITED_FILE_INFERENCE_DELIM_HELPERS_H
@@ -0,0 +1,31 @@
+/**
+ * Headers for the hand-written recognizers that classify logical, bit string, integer, and floating point fields
+ * without the parser combinator.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_FAST_CLASSIFY_H
+#define DELIMITED_FILE_INFERENCE_FAST_CLASSIFY_H
+
+#include <cstdlib>
+#include <field_cls.h>
+
+
+/**
+ * Classify a field as one of the logical, bit string, integer, or floating point classifications in a single pass over
+ * its bytes.
+ *
+ * @note The result is identical to that of the `all` rule of the grammar whenever this function returns 1. Strings
+ *  that could be a date, time, or datetime (e.g., 6- and 8-digit integers such as "181021" or "20220402", or integers
+ *  followed by a time zone such as "131211-0700"), as well as strings that do not fit any of the numeric or boolean
+ *  rules, are left for the grammar to classify.
+ *
+ * @param str The string to classify (need not be null-terminated)
+ * @param len Length of the string
+ * @param ret Set to the classification of the string if it could be determined
+ * @return 1 if the classification was determined and 0 if the string must be classified by the grammar.
+ */
+int fastClassifyField(const char *str, size_t len, FieldCls *ret);
+
+#endif //DELIMITED_FILE_INFERENCE_FAST_CLASSIFY_H
@@ -0,0 +1,35 @@
+/**
+ * Enumeration of the data classifications that a field (and, in turn, a column) can be given.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_FIELD_CLS_H
+#define DELIMITED_FILE_INFERENCE_FIELD_CLS_H
+
+typedef enum {
+    FC_0_LOGICAL,  // boolean values
+    FC_1_BIT_STR,  // bit string
+    FC_2_DT_TIME,  // datetime string
+    FC_3_TM_ONLY,  // time string
+    FC_4_DT_ONLY,  // date string
+    FC_5_INTEGER,  // integer
+    FC_6_FLT_DEC,  // floating point (decimal notation)
+    FC_7_FLT_EXP,  // floating point (scientific notation)
+    FC_8_ARBITRY,  // arbitrary string
+} FieldCls;
+const int NUM_FC = 9;
+
+const char *const FieldClsCorrespondingNames[]{
+        "logical",
+        "bit_str",
+        "datetime",
+        "time",
+        "date",
+        "int",
+        "float_dec",
+        "float_exp",
+        "arbitrary",
+};
+
+#endif //DELIMITED_FILE_INFERENCE_FIELD_CLS_H
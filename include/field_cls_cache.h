@@ -0,0 +1,88 @@
+/**
+ * Headers for the cache of the classifications of previously seen field values.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_FIELD_CLS_CACHE_H
+#define DELIMITED_FILE_INFERENCE_FIELD_CLS_CACHE_H
+
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <field_cls.h>
+#include <grammar_dfa.h>
+
+using namespace std;
+
+
+/**
+ * What a `FieldClsCache` is keyed by.
+ */
+typedef enum {
+    CK_VALUE,  // The field value itself
+    CK_SHAPE,  // The shape of the field value (see `GrammarDfa::getShape`)
+} CacheKeyType;
+
+
+/**
+ * Size-bounded map from field values to their classifications, meant to hold the values of a single column so that
+ * values that repeat (e.g., the few distinct strings of a status or alarm column) are parsed only once.
+ *
+ * @note When keyed by shape, values that differ but have the same shape (e.g., most of the timestamps of a column,
+ *  which never repeat) share one entry.
+ *
+ * @note Once the cache holds its maximum number of values, values not already in it are no longer added (the values
+ *  that were cached first are kept, as these tend to be the most common values of a low-cardinality column).
+ */
+class FieldClsCache {
+private:
+    size_t _maxEntries;
+    CacheKeyType _keyType;
+    string _shape;  // Shape of the value most recently looked up or inserted
+    unordered_map<string_view, FieldCls> _entries;
+    deque<string> _keys;  // Owns the contents of the keys of `_entries` (a deque never moves its elements on insertion)
+    size_t _numHits;
+    size_t _numMisses;
+
+    string_view getKey(string_view value);
+public:
+    /**
+     * @param maxEntries Maximum number of values (or shapes) to cache
+     * @param keyType What the cache is keyed by
+     */
+    explicit FieldClsCache(size_t maxEntries, CacheKeyType keyType = CK_VALUE);
+
+    // Copies would hold keys that view the original's strings, whereas moving keeps the strings where they are
+    FieldClsCache(const FieldClsCache &) = delete;
+    FieldClsCache &operator=(const FieldClsCache &) = delete;
+    FieldClsCache(FieldClsCache &&) = default;
+    FieldClsCache &operator=(FieldClsCache &&) = default;
+
+    /**
+     * Look up the classification of a value, counting the lookup as a hit or a miss.
+     *
+     * @param value The field value
+     * @param ret Set to the cached classification if the value is cached
+     * @return 1 if the value was cached and 0 if not.
+     */
+    int lookup(string_view value, FieldCls *ret);
+
+    /**
+     * Cache the classification of a value if the cache is not full.
+     *
+     * @param value The field value, which is copied
+     * @param fieldCls The classification of the value
+     */
+    void insert(string_view value, FieldCls fieldCls);
+
+    void clear();
+
+    size_t getNumEntries() const;
+    size_t getNumHits() const;
+    size_t getNumMisses() const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_FIELD_CLS_CACHE_H
@@ -11,12 +11,63 @@ extern "C" {
 #include <mpc.h>
 }
 #include <regex>
+#include <tuple>
+#include <field_cls.h>
 
 using namespace std;
 
 
-void mpc_setup(mpc_parser_t **parser, vector<mpc_parser_t *> &allParsers);
+/**
+ * Groups of classifications that correspond to the alternatives of the `all` rule of the grammar, in the order in which
+ * they are tried.
+ */
+typedef enum {
+    GG_LOGICAL,  // FC_0_LOGICAL
+    GG_BIT_STR,  // FC_1_BIT_STR
+    GG_DT,       // FC_2_DT_TIME, FC_3_TM_ONLY, and FC_4_DT_ONLY
+    GG_INT,      // FC_5_INTEGER
+    GG_FLOAT,    // FC_6_FLT_DEC and FC_7_FLT_EXP
+} GrammarGroup;
+const int NUM_GG = 5;
+
+/**
+ * Group of each classification other than `FC_8_ARBITRY` (which is given to fields that fit no group).
+ */
+const GrammarGroup FieldClsGrammarGroups[]{
+        GG_LOGICAL,
+        GG_BIT_STR,
+        GG_DT,
+        GG_DT,
+        GG_DT,
+        GG_INT,
+        GG_FLOAT,
+        GG_FLOAT,
+};
+
+
+/**
+ * Compile the grammar.
+ *
+ * @param parser Set to the parser of the `all` rule, with which any field can be classified
+ * @param allParsers Vector to which every parser created is appended (for cleanup)
+ * @param groupParsers If not null, an array of length `NUM_GG` that is set to the parser of each alternative of `all`
+ *  on its own (see `GrammarGroup`)
+ */
+void mpc_setup(mpc_parser_t **parser, vector<mpc_parser_t *> &allParsers, mpc_parser_t **groupParsers = nullptr);
 
 string mpc_strip_tag(const string &tag);
 
+/**
+ * Definition of the grammar in the language of `mpca_lang`, from which `mpc_setup` compiles its parsers.
+ */
+extern const char *const MPC_GRAMMAR;
+
+/**
+ * Split the grammar into its rules.
+ *
+ * @param ret Vector to which a tuple of the name and the definition of each rule is appended (in the order of the
+ *  grammar), with each run of whitespace in the definition collapsed into one space.
+ */
+void getGrammarRules(vector<tuple<string, string>> &ret);
+
 #endif //DELIMITED_FILE_INFERENCE_GRAMMAR_H
@@ -0,0 +1,85 @@
+/**
+ * Headers for the deterministic finite automaton compiled from the classification grammar.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_GRAMMAR_DFA_H
+#define DELIMITED_FILE_INFERENCE_GRAMMAR_DFA_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <field_cls.h>
+
+using namespace std;
+
+
+/**
+ * Deterministic finite automaton that recognizes the `all` rule of the grammar (see `MPC_GRAMMAR`) and whose accepting
+ * states map directly to `FieldCls` values. Classifying a string is a single pass over its bytes with one table lookup
+ * per byte and no heap allocation.
+ *
+ * @note The automaton is compiled from the rules of `MPC_GRAMMAR` (and the regexes within them), with alternatives
+ *  tried in the same order: when a string fits more than one alternative of `all`, the earliest one is chosen. Strings
+ *  of alternatives that mpc can never reach (e.g., those of the `[1-9]{2}` alternative of `day_single_dig`, which
+ *  `[1-9]` always matches first) are left out.
+ * @note mpc commits to the first alternative of a rule that matches a prefix of the input, whereas the automaton
+ *  accepts a string if any combination of alternatives matches all of it. This only matters for contrived strings
+ *  (e.g., "120402131211-0700", where mpc commits to the 8-digit date "12040213" and rejects the string, but the
+ *  automaton reads it as the 6-digit date "120402" followed by a time), which is why both engines can be selected and
+ *  compared.
+ */
+class GrammarDfa {
+private:
+    unsigned char _byteCls[256];
+    size_t _numByteCls;
+    vector<uint32_t> _trans;  // Row-major [state][byte class]; state 0 is the dead state
+    vector<unsigned char> _stateCls;  // FieldCls of each state (FC_8_ARBITRY for non-accepting states)
+    uint32_t _startState;
+public:
+    /**
+     * Compile the grammar into an automaton.
+     *
+     * @note Compilation takes on the order of milliseconds, so prefer the process-wide instance given by `get`.
+     * @note If a rule of the grammar uses syntax that the compiler doesn't support, an error is printed and the
+     *  automaton classifies every string as `FC_8_ARBITRY` (which the tests of the grammar catch).
+     */
+    GrammarDfa();
+
+    /**
+     * @return A process-wide automaton that is compiled on first use and is safe to share between threads.
+     */
+    static const GrammarDfa &get();
+
+    /**
+     * Classify a string.
+     *
+     * @param str The string to classify (need not be null-terminated)
+     * @param len Length of the string
+     * @return The classification given by the accepting state reached, or `FC_8_ARBITRY` if none was reached.
+     */
+    FieldCls classify(const char *str, size_t len) const;
+
+    /**
+     * Compute the shape of a string: the run-length encoding of the byte classes of its bytes, where bytes are in the
+     * same class if every character set of the grammar treats them identically (e.g., '4' and '5' are, but '3' and '4'
+     * are not, as the `day` rule only allows "30" and "31").
+     *
+     * @note No rule of the grammar can tell apart two strings with the same shape, so they always have the same
+     *  classification (under both mpc and the automaton). This is what makes the shape usable as a cache key, unlike a
+     *  coarser shape such as runs of digits and letters ("12/31/2022" is a date but "13/31/2022" is not).
+     *
+     * @param str The string (need not be null-terminated)
+     * @param len Length of the string
+     * @param ret String to which the shape is assigned, as pairs of a byte class and a run length (encoded 7 bits per
+     *  byte, with the high bit set on every byte but the last).
+     */
+    void getShape(const char *str, size_t len, string &ret) const;
+
+    size_t getNumStates() const;
+    size_t getNumByteClasses() const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_GRAMMAR_DFA_H
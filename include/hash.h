@@ -0,0 +1,27 @@
+/**
+ * Header-only hash of strings, shared by the schema cache, the saved tail states, and the column sketches.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_HASH_H
+#define DELIMITED_FILE_INFERENCE_HASH_H
+
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+
+/**
+ * 64-bit FNV-1a hash of a string, optionally continuing from the hash of a preceding string.
+ */
+inline uint64_t fnv1aHash(const char *const str, size_t len, uint64_t hash = 0xcbf29ce484222325) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) str[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+#endif //DELIMITED_FILE_INFERENCE_HASH_H
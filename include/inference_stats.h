@@ -0,0 +1,110 @@
+/**
+ * Headers for the statistics that can be collected while running inference.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_INFERENCE_STATS_H
+#define DELIMITED_FILE_INFERENCE_INFERENCE_STATS_H
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <field_cls.h>
+
+using namespace std;
+
+
+/**
+ * Phases of inference.
+ */
+typedef enum {
+    IP_READ,  // Reading (or mapping) the file and splitting it into lines
+    IP_DELIM,  // Delimiter detection (`getDelim`)
+    IP_FIELDS,  // Field splitting (`getFields`)
+    IP_CLASSIFY,  // Column classification (`classifyColumns`)
+} InferencePhase;
+const int NUM_IP = 4;
+
+const char *const InferencePhaseNames[]{
+        "read",
+        "delim",
+        "fields",
+        "classify",
+};
+
+
+/**
+ * Statistics of an inference run, which are accumulated by the functions that are given a pointer to this object (the
+ * statistics of several calls, e.g., for several files, can be accumulated in one object).
+ *
+ * @note When no object is given (the default), nothing is measured: the only cost is checking for a null pointer once
+ *  per call (and once per parsed field).
+ */
+struct InferenceStats {
+    double phaseSeconds[NUM_IP];  // Wall time of each phase
+    size_t linesScanned[NUM_IP];  // Number of lines read by each phase (including empty lines)
+    size_t bytesScanned[NUM_IP];  // Number of bytes of those lines (not counting newlines)
+    size_t numFieldsClassified;  // Number of fields given to `classifyField`
+    size_t numMpcParses;  // Number of those fields that were parsed with mpc
+    size_t numMpcParsesByCls[NUM_FC];  // Number of mpc parses by resulting classification
+    double mpcParseSecondsByCls[NUM_FC];  // Wall time of mpc parses by resulting classification
+    size_t peakFieldStorageBytes;  // Largest amount of heap memory used to hold the fields returned by `getFields`
+
+    InferenceStats();
+
+    /**
+     * Print the statistics in a human-readable form.
+     */
+    void print(ostream &os) const;
+};
+
+
+/**
+ * Adds the wall time between its construction and destruction to a phase of an `InferenceStats` object, or does
+ * nothing if the object is null.
+ */
+class PhaseTimer {
+private:
+    InferenceStats *_stats;
+    InferencePhase _phase;
+    chrono::steady_clock::time_point _start;
+public:
+    PhaseTimer(InferenceStats *stats, InferencePhase phase);
+    virtual ~PhaseTimer();
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+};
+
+
+/**
+ * Statistics of one stage (thread) of a pipelined inference run (see `classifyFilePipelined`).
+ *
+ * @note A stage that mostly stalls on its input is waiting for the stages before it, and one that mostly stalls on its
+ *  output is waiting for the stages after it, so the bottleneck is the stage that stalls the least.
+ */
+struct PipelineStageStats {
+    string name;
+    double seconds;  // Wall time from the start to the end of the stage
+    double inputStallSeconds;  // Wall time spent waiting for its input queue to be non-empty
+    double outputStallSeconds;  // Wall time spent waiting for its output queue(s) to have room
+    size_t numItems;  // Number of blocks (or batches of rows) that the stage produced (or consumed, for the last stage)
+    size_t numBytes;  // Number of bytes in those items
+};
+
+
+/**
+ * Statistics of a pipelined inference run, with one entry per stage in the order that data flows through them.
+ */
+struct PipelineStats {
+    vector<PipelineStageStats> stages;
+
+    /**
+     * Print the statistics in a human-readable form.
+     */
+    void print(ostream &os) const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_INFERENCE_STATS_H
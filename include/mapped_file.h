@@ -0,0 +1,59 @@
+/**
+ * Headers for the helpers used to read a data file through a read-only memory mapping.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_MAPPED_FILE_H
+#define DELIMITED_FILE_INFERENCE_MAPPED_FILE_H
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Wrapper for creating and cleaning up a read-only memory mapping of a file.
+ *
+ * @note Views handed out by this object (and any `string_view` sliced from them) are only valid for as long as the
+ *  object is alive and open.
+ */
+class MappedFile {
+private:
+    const char *_data;
+    size_t _size;
+public:
+    MappedFile();
+    virtual ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * Map the file at the given path, releasing any mapping previously held by this object.
+     *
+     * @param path Path of the file to map
+     * @return 1 if the file was successfully mapped (an empty file maps to an empty view) and 0 if not.
+     */
+    int open(const string &path);
+    void close();
+    const char *data() const;
+    size_t size() const;
+    string_view view() const;
+};
+
+
+/**
+ * Split a buffer into lines without copying any of its contents.
+ *
+ * @note Lines are split on '\n' in the same way as `std::getline`: the newline characters are not included in the
+ *  returned lines, and a trailing newline at the end of the buffer does not produce an additional empty line.
+ *
+ * @param buffer Buffer containing the contents of the data file
+ * @param ret Vector to which a view of each line in the buffer is appended
+ */
+void getBufferLines(string_view buffer, vector<string_view> &ret);
+
+#endif //DELIMITED_FILE_INFERENCE_MAPPED_FILE_H
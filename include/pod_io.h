@@ -0,0 +1,48 @@
+/**
+ * Header-only helpers for reading and writing the binary formats of the schema cache, saved tail states, and partial
+ * classifications.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_POD_IO_H
+#define DELIMITED_FILE_INFERENCE_POD_IO_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+using namespace std;
+
+
+/**
+ * Write the bytes of a value of a plain-old-data type (in the byte order of the machine).
+ */
+template<typename T>
+inline void writePod(ostream &os, const T &value) {
+    os.write((const char *) &value, sizeof(T));
+}
+
+/**
+ * Read a value written by `writePod`.
+ *
+ * @return Whether the value was read.
+ */
+template<typename T>
+inline bool readPod(istream &is, T &value) {
+    return (bool) is.read((char *) &value, sizeof(T));
+}
+
+/**
+ * @return The number of bytes of a stream after its read position, against which lengths read from (possibly corrupt)
+ *  data are checked before anything of that length is allocated.
+ */
+inline uint64_t getRemainingBytes(istream &is) {
+    const auto pos = is.tellg();
+    is.seekg(0, ios::end);
+    const auto end = is.tellg();
+    is.seekg(pos);
+    return pos < 0 || end < pos ? 0 : (uint64_t) (end - pos);
+}
+
+#endif //DELIMITED_FILE_INFERENCE_POD_IO_H
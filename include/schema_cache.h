@@ -0,0 +1,93 @@
+/**
+ * Headers for the on-disk cache of the results of inference on data files, keyed by a fingerprint of each file.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_SCHEMA_CACHE_H
+#define DELIMITED_FILE_INFERENCE_SCHEMA_CACHE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <field_cls.h>
+
+using namespace std;
+
+
+/**
+ * Cheap fingerprint of a file that changes whenever the file is (in all likelihood) modified, without reading more
+ * than two blocks of it.
+ */
+struct FileFingerprint {
+    uint64_t size;
+    int64_t mtimeNs;  // Modification time in nanoseconds since the Unix epoch
+    uint64_t blocksHash;  // Hash of the first and last blocks of the file
+};
+
+
+/**
+ * @param path Path of the file
+ * @param ret Set to the fingerprint of the file
+ * @param blockSize Number of bytes hashed at each end of the file
+ * @return 1 if the file could be read and 0 if not.
+ */
+int getFileFingerprint(const string &path, FileFingerprint &ret, size_t blockSize = 4096);
+
+
+/**
+ * Directory of cached inference results (the delimiter, header line index, and column classifications of a file), one
+ * file per entry, so that inference on an unchanged file can be skipped.
+ *
+ * @note Entries are named after the hash of the file's fingerprint, so identical copies of a file share an entry. On
+ *  lookup, the line that was taken as the header is also read back from the file and compared with the hash stored in
+ *  the entry, which catches modifications that keep the size, modification time, and first and last blocks.
+ * @note Entries are written to a temporary file that is then renamed, so concurrent readers (and writers) never see a
+ *  partial entry. Entries are stored in the byte order of the machine that wrote them and are only meant to be read on
+ *  the same machine.
+ */
+class SchemaCache {
+private:
+    string _directory;
+
+    string getEntryPath(const FileFingerprint &fingerprint) const;
+public:
+    /**
+     * @param directory Directory in which entries are stored, which is created when the first entry is stored
+     */
+    explicit SchemaCache(string directory);
+
+    const string &getDirectory() const;
+
+    /**
+     * Look up the inference results of a file.
+     *
+     * @param path Path of the file (from which the header line is read to validate the entry)
+     * @param fingerprint Fingerprint of the file
+     * @param status Set to the status of inference on the file (see `classifyFile`)
+     * @param delimRet Set to the value that `getDelim` gave for the file's lines
+     * @param classifications Set to the column classifications of the file
+     * @return 1 if a valid entry was found and 0 if not (in which case the outputs are unchanged).
+     */
+    int lookup(const string &path, const FileFingerprint &fingerprint, int &status, tuple<char, size_t> &delimRet,
+               vector<tuple<string, FieldCls>> &classifications) const;
+
+    /**
+     * Store the inference results of a file, replacing any previous entry for the same fingerprint.
+     *
+     * @param fingerprint Fingerprint of the file, which should be taken before the file is read for inference
+     * @param headerOffset Byte offset in the file of the line that was taken as the header
+     * @param headerLine The line that was taken as the header (without its newline)
+     * @param status Status of inference on the file
+     * @param delimRet Value that `getDelim` gave for the file's lines
+     * @param classifications Column classifications of the file
+     * @return 1 if the entry was written and 0 if not.
+     */
+    int store(const FileFingerprint &fingerprint, size_t headerOffset, string_view headerLine, int status,
+              const tuple<char, size_t> &delimRet, const vector<tuple<string, FieldCls>> &classifications) const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_SCHEMA_CACHE_H
@@ -0,0 +1,142 @@
+/**
+ * Header-only bounded lock-free queue with a single producer and a single consumer.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_SPSC_QUEUE_H
+#define DELIMITED_FILE_INFERENCE_SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+/**
+ * Bounded ring buffer through which one thread passes items to one other thread without locks.
+ *
+ * @note The producer only writes the tail index and the consumer only writes the head index, each on its own cache
+ *  line. Each side keeps a copy of the other side's index and only reloads it when the queue looks full (or empty), so
+ *  that the two threads rarely touch the same cache line while items are flowing.
+ * @note `push` and `pop` wait (spinning briefly, then yielding) while the queue is full or empty, which is what gives
+ *  backpressure between pipeline stages. The time spent waiting is added to the given counter, so that a stage that
+ *  waits on its input can be told apart from one that waits on its output.
+ *
+ * @tparam T Type of the items, which must be default-constructible and movable
+ */
+template<typename T>
+class SpscQueue {
+private:
+    vector<T> _slots;
+    size_t _mask;
+    alignas(64) atomic<size_t> _tail;  // Index of the next slot to push to (written by the producer)
+    size_t _cachedHead;  // Producer's copy of `_head`
+    alignas(64) atomic<size_t> _head;  // Index of the next slot to pop from (written by the consumer)
+    size_t _cachedTail;  // Consumer's copy of `_tail`
+
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t ret = 1;
+        while (ret < value) ret <<= 1;
+        return ret;
+    }
+
+    /**
+     * Wait a little longer each time a full (or empty) queue is polled.
+     */
+    static void backOff(size_t &numPolls) {
+        if (++numPolls < 64) {
+#if defined(__SSE2__)
+            _mm_pause();
+#endif
+        } else {
+            this_thread::yield();
+        }
+    }
+
+public:
+    /**
+     * @param capacity Maximum number of items in the queue (rounded up to a power of two)
+     */
+    explicit SpscQueue(size_t capacity) : _slots(roundUpToPowerOfTwo(capacity < 1 ? 1 : capacity)),
+                                          _mask(_slots.size() - 1), _tail(0), _cachedHead(0), _head(0),
+                                          _cachedTail(0) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * Push an item if there is room (producer only).
+     *
+     * @return Whether the item was pushed (in which case it was moved from).
+     */
+    bool tryPush(T &&item) {
+        const size_t tail = _tail.load(memory_order_relaxed);
+        if (tail - _cachedHead == _slots.size()) {
+            _cachedHead = _head.load(memory_order_acquire);
+            if (tail - _cachedHead == _slots.size()) return false;
+        }
+        _slots[tail & _mask] = std::move(item);
+        _tail.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pop an item if there is one (consumer only).
+     *
+     * @return Whether an item was popped into `ret`.
+     */
+    bool tryPop(T &ret) {
+        const size_t head = _head.load(memory_order_relaxed);
+        if (head == _cachedTail) {
+            _cachedTail = _tail.load(memory_order_acquire);
+            if (head == _cachedTail) return false;
+        }
+        ret = std::move(_slots[head & _mask]);
+        _head.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Push an item, waiting while the queue is full (producer only).
+     *
+     * @param stallSeconds If not null, the number of seconds spent waiting is added to it
+     */
+    void push(T &&item, double *const stallSeconds = nullptr) {
+        if (tryPush(std::move(item))) return;
+        const auto stallStart = chrono::steady_clock::now();
+        size_t numPolls = 0;
+        while (!tryPush(std::move(item))) backOff(numPolls);
+        if (stallSeconds != nullptr) {
+            *stallSeconds += chrono::duration<double>(chrono::steady_clock::now() - stallStart).count();
+        }
+    }
+
+    /**
+     * Pop an item, waiting while the queue is empty (consumer only).
+     *
+     * @param stallSeconds If not null, the number of seconds spent waiting is added to it
+     */
+    void pop(T &ret, double *const stallSeconds = nullptr) {
+        if (tryPop(ret)) return;
+        const auto stallStart = chrono::steady_clock::now();
+        size_t numPolls = 0;
+        while (!tryPop(ret)) backOff(numPolls);
+        if (stallSeconds != nullptr) {
+            *stallSeconds += chrono::duration<double>(chrono::steady_clock::now() - stallStart).count();
+        }
+    }
+
+    size_t getCapacity() const {
+        return _slots.size();
+    }
+};
+
+#endif //DELIMITED_FILE_INFERENCE_SPSC_QUEUE_H
@@ -0,0 +1,50 @@
+/**
+ * Headers for detecting the delimiter and header of a data file from a bounded window at the end of the file.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_TAIL_WINDOW_H
+#define DELIMITED_FILE_INFERENCE_TAIL_WINDOW_H
+
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+
+/**
+ * Result of `detectDelimFromTail`.
+ */
+struct TailDelimResult {
+    char delim;  // Delimiter found, or '\0' if it could not be inferred
+    size_t headerOffset;  // Byte offset in the file of the line that is taken as the header
+    size_t numLinesSampled;  // Number of non-empty lines at the end of the file given to the delimiter finding FSM
+    size_t bytesRead;  // Number of bytes read from the file (by both the backward and any forward scan)
+    int usedHeadScan;  // 1 if the header was found by a forward scan from the start of the file (see below) and 0 if not
+};
+
+
+/**
+ * Find the delimiter and header line of a data file with the same state machine as `getDelim`, reading only the lines
+ * that the state machine needs instead of the whole file.
+ *
+ * @note Blocks are read backward from the end of the file with `pread`, and lines are fed to the state machine as they
+ *  are completed (from the end of the file), until the state machine finds no consistencies left, the start of the file
+ *  is reached, or `maxSampleLines` non-empty lines have been sampled. In the first two cases, the delimiter and header
+ *  are those that `getDelim` would give for all the lines of the file.
+ * @note If the sample limit is reached first, then the delimiter is decided from the sampled lines, and the header is
+ *  found by scanning forward from the start of the file for the first run of `maxSampleLines` consecutive non-empty
+ *  lines (or of the lines up to the backward scan's sample, if fewer) that contain the delimiter as many times as the
+ *  last sampled line. Unlike the state machine, this only considers the chosen delimiter.
+ *
+ * @param path Path of the data file
+ * @param ret Set to the result
+ * @param maxSampleLines Maximum number of non-empty lines to sample from the end of the file
+ * @param blockSize Number of bytes read at a time
+ * @return 1 if the file could be read and the delimiter and header were found, and 0 if not.
+ */
+int detectDelimFromTail(const string &path, TailDelimResult &ret, size_t maxSampleLines = 1024,
+                        size_t blockSize = 65536);
+
+#endif //DELIMITED_FILE_INFERENCE_TAIL_WINDOW_H
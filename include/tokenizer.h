@@ -0,0 +1,62 @@
+/**
+ * Headers for the quote-aware tokenizer used to split records of delimited data into fields.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_TOKENIZER_H
+#define DELIMITED_FILE_INFERENCE_TOKENIZER_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Bounds of a field as byte offsets from the start of the record that it belongs to.
+ */
+struct FieldBounds {
+    size_t start;
+    size_t end;
+};
+
+
+/**
+ * Find the bounds of each field of a record.
+ *
+ * @note Fields are quoted as in RFC 4180: delimiters and newlines between a pair of double quotes are part of the field,
+ *  and a pair of double quotes within a quoted field is an escaped double quote. The bounds of a field that is enclosed
+ *  in double quotes exclude the enclosing quotes, but escaped quotes are left in place (see `unescapeField`). Only a
+ *  double quote at the start of a field opens quotes; a double quote elsewhere in an unquoted field (e.g., `5" pipe`)
+ *  is an ordinary byte.
+ * @note The record ends at the first newline that is not within quotes. Records in the middle of a buffer can therefore
+ *  be tokenized one after another by advancing by the number of bytes consumed. Inference (e.g., `getFields`) only
+ *  tokenizes lines that were already split at every newline, however, so there a quoted field that spans lines is
+ *  split into fields of separate rows.
+ * @note The delimiter, quote, and newline positions are found 64 bytes at a time with SSE2 comparisons; which of them
+ *  are within quotes is determined from a prefix XOR of the quote positions. From a block with a double quote within
+ *  an unquoted field, the rest of the record is tokenized a byte at a time.
+ *
+ * @param str The record (need not be null-terminated)
+ * @param len Length of the record
+ * @param delim Data delimiter
+ * @param ret Vector to which the bounds of each field are appended. A record without delimiters has one field (which
+ *  is empty for an empty record).
+ * @return The number of bytes of the record consumed, i.e., the offset just past the newline that ends the record, or
+ *  `len` if there is no such newline.
+ */
+size_t tokenizeRecord(const char *str, size_t len, char delim, vector<FieldBounds> &ret);
+
+
+/**
+ * Copy a field found by `tokenizeRecord`, replacing each escaped double quote with a single double quote.
+ *
+ * @param str The record that the field belongs to
+ * @param bounds The bounds of the field
+ * @param ret String to which the unescaped field is assigned
+ */
+void unescapeField(const char *str, const FieldBounds &bounds, string &ret);
+
+#endif //DELIMITED_FILE_INFERENCE_TOKENIZER_H
@@ -0,0 +1,130 @@
+/**
+ * Headers for converting classified columns of delimited data into contiguous buffers of typed values.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_TYPED_COLUMNS_H
+#define DELIMITED_FILE_INFERENCE_TYPED_COLUMNS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <field_cls.h>
+#include <columnar_fields.h>
+
+using namespace std;
+
+
+/**
+ * Types of value into which the fields of a column are converted.
+ */
+typedef enum {
+    MT_UINT8,     // 0 or 1 (logical columns)
+    MT_INT64,     // Integer columns
+    MT_DOUBLE,    // Floating point columns
+    MT_EPOCH_NS,  // Nanoseconds since the Unix epoch as an int64_t (datetime, date, and time columns)
+    MT_STRING,    // The field itself (bit string and arbitrary columns)
+} MaterializedType;
+const int NUM_MT = 5;
+
+const char *const MaterializedTypeNames[]{
+        "uint8",
+        "int64",
+        "double",
+        "epoch_ns",
+        "string",
+};
+
+
+/**
+ * @return The type of value into which the fields of a column with the given classification are converted.
+ *
+ * @note Bit strings are kept as strings, as they can have more bits than fit in an integer and leading zeros matter.
+ */
+MaterializedType getMaterializedType(FieldCls cls);
+
+
+/**
+ * Values of one column. Only the vector that corresponds to the column's type is filled (`int64Values` for both
+ * `MT_INT64` and `MT_EPOCH_NS`), with one value per row of data.
+ */
+struct TypedColumn {
+    string name;
+    FieldCls cls;
+    MaterializedType type;
+    vector<uint8_t> uint8Values;
+    vector<int64_t> int64Values;
+    vector<double> doubleValues;
+    vector<string> stringValues;
+    vector<uint8_t> isValid;  // 1 if the field of the row was converted and 0 if not (in which case its value is 0)
+    size_t numFailures;  // Number of fields (including missing and empty fields) that could not be converted
+    size_t firstFailureRow;  // Index of the row of data (0 being the first row after the header) of the first failure,
+    // or -1 if there were no failures
+};
+
+
+/**
+ * Parse an integer as given by the `int` rule of the grammar.
+ *
+ * @return 1 if the whole field is an integer that fits in 64 bits and 0 if not.
+ */
+int parseInt64Field(string_view field, int64_t &ret);
+
+/**
+ * Parse a floating point number as given by the `float_dec` and `float_exp` rules of the grammar (as well as an
+ * integer).
+ *
+ * @return 1 if the whole field is a number and 0 if not.
+ */
+int parseDoubleField(string_view field, double &ret);
+
+/**
+ * Parse a datetime, time, or date string as given by the `datetime`, `time`, and `date` rules of the grammar, which are
+ * tried in that order (as in the `all` rule).
+ *
+ * @note The rules are mirrored by a recursive descent parser with the same ordered choice as mpc: the first alternative
+ *  of a rule that matches is kept, even if what follows it then fails to match.
+ * @note A date is converted to midnight UTC of that day and a time without a date to a time on 1970-01-01. Times are
+ *  converted to UTC if they have a time zone (taking the offset of a %ZP time zone such as "MST-07" as the offset from
+ *  UTC, as Boost does). Two-digit years from 69 to 99 are taken to be in the 1900s and the others in the 2000s (as with
+ *  POSIX `strptime`). Fractional seconds beyond nanoseconds are truncated.
+ * @note Strings that the grammar accepts but that don't name an actual date or time (e.g., February 30th, or a 24-hour
+ *  time such as "13:00 PM") are not converted.
+ *
+ * @param field The string to parse
+ * @param ret Set to the number of nanoseconds since the Unix epoch
+ * @return 1 if the whole field was parsed and 0 if not.
+ */
+int parseEpochNsField(string_view field, int64_t &ret);
+
+
+/**
+ * Convert each classified column into a contiguous buffer of typed values (see `getMaterializedType`) with one pass
+ * over the fields of the column. Values are parsed in place without allocating (other than for string columns).
+ *
+ * @note A column's fields may have any classification that is at least as restrictive as the column's (e.g., an
+ *  integer column may contain logical values, which convert, or times, which don't). Fields that fail to convert,
+ *  including empty fields and missing fields of short rows, are counted per column and marked in `isValid`.
+ *
+ * @param fields Fields of at least one row, where row 0 contains the column names
+ * @param classifications The classification of each column, as given by `classifyColumns` for the same fields
+ * @param ret Set to one typed column per classification
+ * @return 1 if there was one classification per column and every field was converted, 0 if some fields failed to
+ *  convert, and -1 if the number of classifications differs from the number of columns (in which case `ret` is empty).
+ */
+int materializeColumns(const ColumnarFields &fields, const vector<tuple<string, FieldCls>> &classifications,
+                       vector<TypedColumn> &ret);
+
+/**
+ * Overload of `materializeColumns` for rows of fields (as given by `getFields`).
+ */
+int materializeColumns(const vector<vector<string>> &rows, const vector<tuple<string, FieldCls>> &classifications,
+                       vector<TypedColumn> &ret);
+int materializeColumns(const vector<vector<string_view>> &rows,
+                       const vector<tuple<string, FieldCls>> &classifications, vector<TypedColumn> &ret);
+
+#endif //DELIMITED_FILE_INFERENCE_TYPED_COLUMNS_H
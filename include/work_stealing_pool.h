@@ -0,0 +1,86 @@
+/**
+ * Headers for the work-stealing thread pool.
+ *
+ * @author Duncan Mazza
+ */
+
+#ifndef DELIMITED_FILE_INFERENCE_WORK_STEALING_POOL_H
+#define DELIMITED_FILE_INFERENCE_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * Thread pool where each worker has its own queue of tasks and takes tasks from the queues of other workers when its
+ * own runs out.
+ *
+ * @note A task submitted from one of the pool's workers (e.g., a task that splits its work into smaller tasks) is put
+ *  at the back of that worker's queue, which the worker takes from first (so that it continues with the work it
+ *  just split up), whereas idle workers steal from the front of other queues (so that they take the oldest, and
+ *  usually largest, work). Tasks submitted from other threads are spread over the queues in turn.
+ */
+class WorkStealingPool {
+private:
+    struct WorkerQueue {
+        mutex queueMutex;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkerQueue>> _queues;
+    vector<thread> _workers;
+    mutex _mutex;
+    condition_variable _taskAvailable;
+    condition_variable _allDone;
+    size_t _numQueued;  // Number of tasks that have been submitted but not yet taken by a worker
+    size_t _numUnfinished;  // Number of tasks that have been submitted but not yet finished
+    bool _stopping;
+    atomic<size_t> _nextQueue;
+    atomic<size_t> _numSteals;
+
+    int takeTask(size_t workerIdx, function<void()> &ret);
+    void runWorker(size_t workerIdx);
+public:
+    /**
+     * @param numThreads Number of worker threads. If 0, then the number of concurrent threads supported by the hardware
+     *  is used.
+     */
+    explicit WorkStealingPool(size_t numThreads = 0);
+
+    /**
+     * Wait for every task to finish and stop the workers.
+     */
+    virtual ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * Queue a task to be run by one of the workers.
+     */
+    void submit(function<void()> task);
+
+    /**
+     * Block until every submitted task (including the tasks submitted by those tasks) has finished.
+     *
+     * @note Must not be called from one of the pool's workers.
+     */
+    void wait();
+
+    size_t getNumThreads() const;
+
+    /**
+     * @return The number of tasks that were taken from the queue of another worker.
+     */
+    size_t getNumSteals() const;
+};
+
+#endif //DELIMITED_FILE_INFERENCE_WORK_STEALING_POOL_H
@@ -0,0 +1,196 @@
+/**
+ * Definitions for running inference on batches of files.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+
+using namespace std;
+
+
+/**
+ * State of a file whose rows are being classified by one or more tasks, which is kept alive until the last task
+ * finishes.
+ */
+struct BatchFileJob {
+    FileInferenceResult *result;
+    int consistentFields;
+    MappedFile file;
+    vector<string_view> lines;
+    vector<vector<string_view>> rows;
+    size_t chunkRows;
+    vector<vector<FieldCls>> chunkFieldClasses;
+    atomic<size_t> numChunksLeft;
+    atomic<bool> saturated;
+    const SchemaCache *cache;
+    FileFingerprint fingerprint;
+};
+
+
+static void classifyChunk(const shared_ptr<BatchFileJob> &job, size_t chunk) {
+    {
+        auto lease = MpcParserPool::global().acquire();
+        const auto &header = job->rows.at(0);
+        ColumnClassifier classifier(header, lease.get());
+
+        const size_t numDataRows = job->rows.size() - 1;
+        auto chunkEnd = job->rows.begin() + 1 + std::min((chunk + 1) * job->chunkRows, numDataRows);
+        for (auto row = job->rows.begin() + 1 + chunk * job->chunkRows; row != chunkEnd && !job->saturated; row++) {
+            classifier.pushRow(*row);
+        }
+
+        // Once every column of any chunk is saturated, the other chunks can't change the result
+        if (classifier.isSaturated()) {
+            job->saturated = true;
+        }
+        job->chunkFieldClasses[chunk] = classifier.getFieldClasses();
+    }
+    if (--job->numChunksLeft > 0) { return; }
+
+    // The last chunk to finish combines the results of all chunks by taking the least restrictive classification of
+    // each column
+    const auto &header = job->rows.at(0);
+    for (size_t fieldIdx = 0; fieldIdx < header.size(); fieldIdx++) {
+        FieldCls fieldCls = FC_0_LOGICAL;
+        for (const auto &fieldClasses: job->chunkFieldClasses) {
+            fieldCls = std::max(fieldCls, fieldClasses[fieldIdx]);
+        }
+        job->result->classifications.emplace_back(string(header[fieldIdx]), fieldCls);
+    }
+    job->result->status = job->consistentFields == 1;
+
+    if (job->cache != nullptr) {
+        const string_view headerLine = job->lines[get<1>(job->result->delim)];
+        job->cache->store(job->fingerprint, headerLine.empty() ? 0 : headerLine.data() - job->file.data(), headerLine,
+                          job->result->status, job->result->delim, job->result->classifications);
+    }
+}
+
+
+static void classifyBatchFile(WorkStealingPool &pool, FileInferenceResult &result, size_t chunkRows,
+                              const SchemaCache *const cache) {
+    result.status = 0;
+    result.delim = {'\0', 0};
+
+    auto job = make_shared<BatchFileJob>();
+    job->cache = nullptr;
+    if (cache != nullptr && getFileFingerprint(result.path, job->fingerprint)) {
+        if (cache->lookup(result.path, job->fingerprint, result.status, result.delim, result.classifications)) {
+            return;
+        }
+        job->cache = cache;
+    }
+    if (!job->file.open(result.path)) {
+        cerr << "Could not open file " << result.path << endl;
+        return;
+    }
+    getBufferLines(job->file.view(), job->lines);
+    result.delim = getDelim(job->lines);
+    job->consistentFields = getFields(job->lines, get<0>(result.delim), job->rows, get<1>(result.delim));
+    if (job->rows.empty()) { return; }
+
+    const size_t numDataRows = job->rows.size() - 1;
+    const size_t numChunks = std::max((size_t) 1, (numDataRows + chunkRows - 1) / chunkRows);
+    job->result = &result;
+    job->chunkRows = chunkRows;
+    job->chunkFieldClasses.resize(numChunks);
+    job->numChunksLeft = numChunks;
+    job->saturated = false;
+
+    // The first chunk is classified by this task and the others are left for idle workers to steal
+    for (size_t chunk = numChunks - 1; chunk > 0; chunk--) {
+        pool.submit([job, chunk]() { classifyChunk(job, chunk); });
+    }
+    classifyChunk(job, 0);
+}
+
+
+void classifyFiles(const vector<string> &paths, vector<FileInferenceResult> &results, size_t numThreads,
+                   size_t chunkRows, const SchemaCache *const cache) {
+    results.clear();
+    results.resize(paths.size());
+    chunkRows = std::max((size_t) 1, chunkRows);
+
+    WorkStealingPool pool(numThreads);
+    for (size_t pathIdx = 0; pathIdx < paths.size(); pathIdx++) {
+        results[pathIdx].path = paths[pathIdx];
+        pool.submit([&pool, &results, pathIdx, chunkRows, cache]() {
+            classifyBatchFile(pool, results[pathIdx], chunkRows, cache);
+        });
+    }
+    pool.wait();
+}
+
+
+int listDataFiles(const string &directory, vector<string> &ret) {
+    error_code errorCode;
+    filesystem::directory_iterator entry(directory, errorCode);
+    if (errorCode) { return 0; }
+
+    vector<string> paths;
+    for (; entry != filesystem::directory_iterator(); entry.increment(errorCode)) {
+        if (errorCode) { return 0; }
+        if (entry->is_regular_file(errorCode)) {
+            paths.push_back(entry->path().string());
+        }
+    }
+    sort(paths.begin(), paths.end());
+    ret.insert(ret.end(), paths.begin(), paths.end());
+    return 1;
+}
+
+
+static void writeJsonString(string_view str, ostream &os) {
+    os << '"';
+    for (char c: str) {
+        switch (c) {
+            case '"':
+                os << "\\\"";
+                break;
+            case '\\':
+                os << "\\\\";
+                break;
+            case '\n':
+                os << "\\n";
+                break;
+            case '\r':
+                os << "\\r";
+                break;
+            case '\t':
+                os << "\\t";
+                break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    const char *hexDigits = "0123456789abcdef";
+                    os << "\\u00" << hexDigits[(unsigned char) c >> 4] << hexDigits[c & 0xf];
+                } else {
+                    os << c;
+                }
+        }
+    }
+    os << '"';
+}
+
+
+void writeResultJson(const FileInferenceResult &result, ostream &os) {
+    os << "{\"path\":";
+    writeJsonString(result.path, os);
+    os << ",\"status\":" << result.status << ",\"delimiter\":";
+    if (get<0>(result.delim) == '\0') {
+        os << "null";
+    } else {
+        writeJsonString(string(1, get<0>(result.delim)), os);
+    }
+    os << ",\"header_line\":" << get<1>(result.delim) << ",\"columns\":[";
+    for (size_t columnIdx = 0; columnIdx < result.classifications.size(); columnIdx++) {
+        if (columnIdx) { os << ','; }
+        os << "{\"name\":";
+        writeJsonString(get<0>(result.classifications[columnIdx]), os);
+        os << ",\"class\":\"" << FieldClsCorrespondingNames[get<1>(result.classifications[columnIdx])] << "\"}";
+    }
+    os << "]}";
+}
@@ -0,0 +1,137 @@
+/**
+ * Definitions for the stateful (streaming) column classifier.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+
+
+using namespace std;
+
+
+ColumnClassifier::ColumnClassifier(const vector<string> &header, MpcParserTWrapper &parser,
+                                   ClassificationEngine engine) :
+        _parser(parser), _engine(engine), _columnNames(header), _fieldClasses(header.size(), FC_0_LOGICAL), _numRows(0),
+        _numSaturated(0), _numSkippedParses(0), _stats(nullptr) {}
+
+ColumnClassifier::ColumnClassifier(const vector<string_view> &header, MpcParserTWrapper &parser,
+                                   ClassificationEngine engine) :
+        _parser(parser), _engine(engine), _fieldClasses(header.size(), FC_0_LOGICAL), _numRows(0),
+        _numSaturated(0), _numSkippedParses(0), _stats(nullptr) {
+    _columnNames.reserve(header.size());
+    for (const auto &columnName: header) {
+        _columnNames.emplace_back(columnName);
+    }
+}
+
+
+template<typename FieldT>
+int ColumnClassifier::pushRowImpl(const vector<FieldT> &row) {
+    // Every column starts out with the most restrictive classification and is widened to the least restrictive
+    // classification that fits every field seen in that column so far
+    size_t numFields = std::min(row.size(), _fieldClasses.size());
+    for (size_t fieldIdx = 0; fieldIdx < numFields; fieldIdx++) {
+        if (!_sketches.empty()) {
+            _sketches[fieldIdx].add(row[fieldIdx]);
+        }
+        if (_fieldClasses[fieldIdx] == FC_8_ARBITRY) {
+            _numSkippedParses++;
+            continue;
+        }
+        _fieldClasses[fieldIdx] = classifyFieldInColumn(row[fieldIdx], _fieldClasses[fieldIdx], _parser, _engine,
+                                                        _caches.empty() ? nullptr : &_caches[fieldIdx], _stats);
+        if (_fieldClasses[fieldIdx] == FC_8_ARBITRY) {
+            _numSaturated++;
+        }
+    }
+    _numRows++;
+    return row.size() == _fieldClasses.size();
+}
+
+void ColumnClassifier::enableCache(size_t maxEntriesPerColumn, CacheKeyType keyType) {
+    _caches.clear();
+    _caches.reserve(_fieldClasses.size());
+    for (size_t fieldIdx = 0; fieldIdx < _fieldClasses.size(); fieldIdx++) {
+        _caches.emplace_back(maxEntriesPerColumn, keyType);
+    }
+}
+
+void ColumnClassifier::setStats(InferenceStats *const stats) {
+    _stats = stats;
+}
+
+void ColumnClassifier::enableSketches() {
+    _sketches.assign(_fieldClasses.size(), ColumnSketch());
+}
+
+int ColumnClassifier::pushRow(const vector<string> &row) {
+    return pushRowImpl(row);
+}
+
+int ColumnClassifier::pushRow(const vector<string_view> &row) {
+    return pushRowImpl(row);
+}
+
+size_t ColumnClassifier::pushRows(const vector<vector<string>> &rows) {
+    size_t numConsistentRows = 0;
+    for (const auto &row: rows) {
+        numConsistentRows += pushRowImpl(row);
+    }
+    return numConsistentRows;
+}
+
+size_t ColumnClassifier::pushRows(const vector<vector<string_view>> &rows) {
+    size_t numConsistentRows = 0;
+    for (const auto &row: rows) {
+        numConsistentRows += pushRowImpl(row);
+    }
+    return numConsistentRows;
+}
+
+
+size_t ColumnClassifier::getNumColumns() const {
+    return _fieldClasses.size();
+}
+
+size_t ColumnClassifier::getNumRows() const {
+    return _numRows;
+}
+
+const vector<FieldCls> &ColumnClassifier::getFieldClasses() const {
+    return _fieldClasses;
+}
+
+bool ColumnClassifier::isSaturated() const {
+    return _numSaturated == _fieldClasses.size();
+}
+
+size_t ColumnClassifier::getNumSkippedParses() const {
+    return _numSkippedParses;
+}
+
+size_t ColumnClassifier::getNumCacheHits() const {
+    size_t numHits = 0;
+    for (const auto &cache: _caches) {
+        numHits += cache.getNumHits();
+    }
+    return numHits;
+}
+
+size_t ColumnClassifier::getNumCacheMisses() const {
+    size_t numMisses = 0;
+    for (const auto &cache: _caches) {
+        numMisses += cache.getNumMisses();
+    }
+    return numMisses;
+}
+
+const vector<ColumnSketch> &ColumnClassifier::getSketches() const {
+    return _sketches;
+}
+
+void ColumnClassifier::getClassifications(vector<tuple<string, FieldCls>> &classifications) const {
+    for (size_t fieldIdx = 0; fieldIdx < _fieldClasses.size(); fieldIdx++) {
+        classifications.emplace_back(_columnNames[fieldIdx], _fieldClasses[fieldIdx]);
+    }
+}
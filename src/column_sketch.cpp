@@ -0,0 +1,107 @@
+/**
+ * Definitions for fixed-size per-column statistics that are collected in the same pass as column classification.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <column_sketch.h>
+#include <hash.h>
+#include <typed_columns.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+
+const string_view NULL_SPELLINGS[]{"NA", "N/A", "NaN", "nan", "NULL", "null", "None"};
+
+
+bool isNullField(string_view field) {
+    return find(begin(NULL_SPELLINGS), end(NULL_SPELLINGS), field) != end(NULL_SPELLINGS);
+}
+
+
+/**
+ * @return A hash of the field whose bits are all well mixed (FNV-1a followed by the finalizer of MurmurHash3), as
+ *  HyperLogLog takes the register index from the high bits and the rank from the others.
+ */
+static uint64_t hashField(string_view field) {
+    uint64_t hash = fnv1aHash(field.data(), field.size());
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+
+ColumnSketch::ColumnSketch() :
+        numFields(0), numEmpty(0), numNull(0), numInt64(0), minInt64(numeric_limits<int64_t>::max()),
+        maxInt64(numeric_limits<int64_t>::min()), numDouble(0), minDouble(numeric_limits<double>::infinity()),
+        maxDouble(-numeric_limits<double>::infinity()), hllRegisters() {}
+
+
+void ColumnSketch::add(string_view field) {
+    numFields++;
+    if (field.empty()) {
+        numEmpty++;
+    } else if (isNullField(field)) {
+        numNull++;
+    } else {
+        int64_t intValue;
+        double doubleValue;
+        if (parseInt64Field(field, intValue)) {
+            numInt64++;
+            minInt64 = std::min(minInt64, intValue);
+            maxInt64 = std::max(maxInt64, intValue);
+        }
+        if (parseDoubleField(field, doubleValue)) {
+            numDouble++;
+            minDouble = std::min(minDouble, doubleValue);
+            maxDouble = std::max(maxDouble, doubleValue);
+        }
+    }
+
+    const uint64_t hash = hashField(field);
+    const uint64_t rest = hash << HLL_PRECISION;
+    const auto rank = (uint8_t) (rest == 0 ? 64 - HLL_PRECISION + 1 : __builtin_clzll(rest) + 1);
+    uint8_t &reg = hllRegisters[hash >> (64 - HLL_PRECISION)];
+    reg = std::max(reg, rank);
+}
+
+
+void ColumnSketch::merge(const ColumnSketch &other) {
+    numFields += other.numFields;
+    numEmpty += other.numEmpty;
+    numNull += other.numNull;
+    numInt64 += other.numInt64;
+    minInt64 = std::min(minInt64, other.minInt64);
+    maxInt64 = std::max(maxInt64, other.maxInt64);
+    numDouble += other.numDouble;
+    minDouble = std::min(minDouble, other.minDouble);
+    maxDouble = std::max(maxDouble, other.maxDouble);
+    for (size_t regIdx = 0; regIdx < HLL_NUM_REGISTERS; regIdx++) {
+        hllRegisters[regIdx] = std::max(hllRegisters[regIdx], other.hllRegisters[regIdx]);
+    }
+}
+
+
+double ColumnSketch::getDistinctEstimate() const {
+    const auto numRegisters = (double) HLL_NUM_REGISTERS;
+    double harmonicSum = 0;
+    size_t numZeroRegisters = 0;
+    for (const uint8_t reg: hllRegisters) {
+        harmonicSum += ldexp(1.0, -reg);
+        numZeroRegisters += reg == 0;
+    }
+    const double alpha = 0.7213 / (1 + 1.079 / numRegisters);
+    const double estimate = alpha * numRegisters * numRegisters / harmonicSum;
+
+    // With a 64-bit hash, only the small range correction (linear counting) is needed
+    if (estimate <= 2.5 * numRegisters && numZeroRegisters > 0) {
+        return numRegisters * log(numRegisters / (double) numZeroRegisters);
+    }
+    return estimate;
+}
@@ -0,0 +1,136 @@
+/**
+ * Definitions for the column-major storage of the fields of delimited data.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <columnar_fields.h>
+#include <tokenizer.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+
+ColumnarFields::ColumnarFields() = default;
+
+
+template<typename LineT>
+int ColumnarFields::assignImpl(const vector<LineT> &lines, char delim, size_t stopAt) {
+    clear();
+    if (lines.empty()) { return -1; }
+
+    // First pass: select the same lines as `getFields` (iterating from the end of the data until `stopAt`) and size
+    // each column
+    vector<size_t> lineIdxs;
+    vector<size_t> columnSizes;
+    vector<FieldBounds> bounds;
+    size_t numFieldsEncountered = 0;
+    int consistentNumFields = -1;
+    for (size_t lineIdx = lines.size(); lineIdx-- > 0;) {
+        const auto &line = lines[lineIdx];
+        if (line.empty()) {
+            continue;
+        }
+
+        bounds.clear();
+        tokenizeRecord(line.data(), line.size(), delim, bounds);
+        if (consistentNumFields == -1) {
+            numFieldsEncountered = bounds.size();
+            consistentNumFields = 1;
+        } else if (numFieldsEncountered != bounds.size()) {
+            consistentNumFields = 0;
+        }
+
+        if (columnSizes.size() < bounds.size()) {
+            columnSizes.resize(bounds.size(), 0);
+        }
+        for (size_t i = 0; i < bounds.size(); i++) {
+            columnSizes[i] += bounds[i].end - bounds[i].start;
+        }
+        lineIdxs.push_back(lineIdx);
+
+        if (lineIdx == stopAt) { break; }
+    }
+    if (lineIdxs.empty()) { return consistentNumFields; }
+    reverse(lineIdxs.begin(), lineIdxs.end());
+
+    // The first selected line holds the column names and determines the number of columns
+    const auto &header = lines[lineIdxs[0]];
+    bounds.clear();
+    tokenizeRecord(header.data(), header.size(), delim, bounds);
+    const size_t numColumns = bounds.size();
+    const size_t numRows = lineIdxs.size();
+
+    // Sizes count escaped quotes twice, so they are an upper bound on the unescaped sizes; each column is given its
+    // upper bound in the arena and any slack is left at its end
+    _columnStarts.resize(numColumns + 1);
+    _columnStarts[0] = 0;
+    for (size_t columnIdx = 0; columnIdx < numColumns; columnIdx++) {
+        _columnStarts[columnIdx + 1] = _columnStarts[columnIdx] + columnSizes[columnIdx];
+    }
+    _arena.resize(_columnStarts[numColumns]);
+    _fieldEnds.assign(numColumns * numRows, 0);
+    _rowNumFields.resize(numRows);
+
+    // Second pass: copy each field into its column
+    vector<uint64_t> writePos(_columnStarts.begin(), _columnStarts.end() - 1);
+    string unescaped;
+    for (size_t rowIdx = 0; rowIdx < numRows; rowIdx++) {
+        const auto &line = lines[lineIdxs[rowIdx]];
+        bounds.clear();
+        tokenizeRecord(line.data(), line.size(), delim, bounds);
+        const size_t numFields = std::min(bounds.size(), numColumns);
+        _rowNumFields[rowIdx] = (uint32_t) numFields;
+        for (size_t columnIdx = 0; columnIdx < numColumns; columnIdx++) {
+            if (columnIdx < numFields) {
+                unescapeField(line.data(), bounds[columnIdx], unescaped);
+                memcpy(&_arena[writePos[columnIdx]], unescaped.data(), unescaped.size());
+                writePos[columnIdx] += unescaped.size();
+            }
+            _fieldEnds[columnIdx * numRows + rowIdx] = writePos[columnIdx];
+        }
+    }
+    return consistentNumFields;
+}
+
+
+int ColumnarFields::assign(const vector<string> &lines, char delim, size_t stopAt) {
+    return assignImpl(lines, delim, stopAt);
+}
+
+int ColumnarFields::assign(const vector<string_view> &lines, char delim, size_t stopAt) {
+    return assignImpl(lines, delim, stopAt);
+}
+
+
+void ColumnarFields::clear() {
+    _arena.clear();
+    _columnStarts.clear();
+    _fieldEnds.clear();
+    _rowNumFields.clear();
+}
+
+
+size_t ColumnarFields::getNumRows() const {
+    return _rowNumFields.size();
+}
+
+size_t ColumnarFields::getNumColumns() const {
+    return _columnStarts.empty() ? 0 : _columnStarts.size() - 1;
+}
+
+size_t ColumnarFields::getNumFields(size_t rowIdx) const {
+    return _rowNumFields[rowIdx];
+}
+
+string_view ColumnarFields::getField(size_t rowIdx, size_t columnIdx) const {
+    const size_t fieldIdx = columnIdx * _rowNumFields.size() + rowIdx;
+    const uint64_t start = rowIdx == 0 ? _columnStarts[columnIdx] : _fieldEnds[fieldIdx - 1];
+    return {_arena.data() + start, (size_t) (_fieldEnds[fieldIdx] - start)};
+}
+
+size_t ColumnarFields::getStorageBytes() const {
+    return _arena.capacity() + (_columnStarts.capacity() + _fieldEnds.capacity()) * sizeof(uint64_t) +
+           _rowNumFields.capacity() * sizeof(uint32_t);
+}
@@ -5,6 +5,11 @@
  */
 
 #include <delim_helpers.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 
 DelimFindingState
@@ -44,3 +49,116 @@ int get_delim_idx(char delim) {
     else
         return 4;
 }
+
+
+void countDelimsScalar(const char *const str, size_t len, size_t *const delimCount) {
+    size_t counts[NDELIMS + 1] = {0};  // Last element is throwaway
+    for (size_t i = 0; i < len; i++) {
+        counts[get_delim_idx(str[i])] += 1;
+    }
+    for (size_t i = 0; i < NDELIMS; i++) {
+        delimCount[i] += counts[i];
+    }
+}
+
+
+#if defined(__SSE2__)
+
+/*
+ * The vectorized implementations compare each block of bytes against every delimiter and accumulate the matches in
+ * per-byte counters (a match compares as 0xFF, so subtracting the comparison result adds 1). Before the 8-bit counters
+ * can overflow, they are summed horizontally with `sad_epu8` into 64-bit totals.
+ */
+
+static inline size_t sumSadLanes(__m128i sums) {
+    // Each 64-bit lane holds at most 8 * 255 * 2 matches, so the low 32 bits of each lane hold the whole sum
+    return (size_t) _mm_cvtsi128_si32(sums) + (size_t) _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+}
+
+static void countDelimsSse2(const char *const str, size_t len, size_t *const delimCount) {
+    const size_t blockSize = 16;
+    const size_t maxBlocksPerFlush = 255;
+
+    __m128i delimVecs[NDELIMS];
+    for (size_t d = 0; d < NDELIMS; d++) {
+        delimVecs[d] = _mm_set1_epi8(DELIMS[d]);
+    }
+
+    size_t pos = 0;
+    while (len - pos >= blockSize) {
+        __m128i accumulators[NDELIMS];
+        for (auto &accumulator: accumulators) accumulator = _mm_setzero_si128();
+
+        size_t numBlocks = std::min(maxBlocksPerFlush, (len - pos) / blockSize);
+        for (size_t block = 0; block < numBlocks; block++, pos += blockSize) {
+            __m128i chars = _mm_loadu_si128((const __m128i *) (str + pos));
+            for (size_t d = 0; d < NDELIMS; d++) {
+                accumulators[d] = _mm_sub_epi8(accumulators[d], _mm_cmpeq_epi8(chars, delimVecs[d]));
+            }
+        }
+
+        for (size_t d = 0; d < NDELIMS; d++) {
+            __m128i sums = _mm_sad_epu8(accumulators[d], _mm_setzero_si128());
+            delimCount[d] += sumSadLanes(sums);
+        }
+    }
+    countDelimsScalar(str + pos, len - pos, delimCount);
+}
+
+#if defined(__GNUC__)
+#define DELIM_HELPERS_HAVE_AVX2
+
+__attribute__((target("avx2")))
+static void countDelimsAvx2(const char *const str, size_t len, size_t *const delimCount) {
+    const size_t blockSize = 32;
+    const size_t maxBlocksPerFlush = 255;
+
+    __m256i delimVecs[NDELIMS];
+    for (size_t d = 0; d < NDELIMS; d++) {
+        delimVecs[d] = _mm256_set1_epi8(DELIMS[d]);
+    }
+
+    size_t pos = 0;
+    while (len - pos >= blockSize) {
+        __m256i accumulators[NDELIMS];
+        for (auto &accumulator: accumulators) accumulator = _mm256_setzero_si256();
+
+        size_t numBlocks = std::min(maxBlocksPerFlush, (len - pos) / blockSize);
+        for (size_t block = 0; block < numBlocks; block++, pos += blockSize) {
+            __m256i chars = _mm256_loadu_si256((const __m256i *) (str + pos));
+            for (size_t d = 0; d < NDELIMS; d++) {
+                accumulators[d] = _mm256_sub_epi8(accumulators[d], _mm256_cmpeq_epi8(chars, delimVecs[d]));
+            }
+        }
+
+        for (size_t d = 0; d < NDELIMS; d++) {
+            __m256i sums = _mm256_sad_epu8(accumulators[d], _mm256_setzero_si256());
+            delimCount[d] += sumSadLanes(_mm_add_epi64(_mm256_castsi256_si128(sums),
+                                                       _mm256_extracti128_si256(sums, 1)));
+        }
+    }
+    countDelimsSse2(str + pos, len - pos, delimCount);
+}
+
+#endif  // defined(__GNUC__)
+#endif  // defined(__SSE2__)
+
+
+typedef void (*CountDelimsFn)(const char *, size_t, size_t *);
+
+static CountDelimsFn selectCountDelims() {
+#if defined(DELIM_HELPERS_HAVE_AVX2)
+    if (__builtin_cpu_supports("avx2")) return countDelimsAvx2;
+#endif
+#if defined(__SSE2__)
+    return countDelimsSse2;
+#else
+    return countDelimsScalar;
+#endif
+}
+
+
+void countDelims(const char *const str, size_t len, size_t *const delimCount) {
+    static const CountDelimsFn countDelimsImpl = selectCountDelims();
+    countDelimsImpl(str, len, delimCount);
+}
@@ -0,0 +1,118 @@
+/**
+ * Definitions for the hand-written recognizers that classify logical, bit string, integer, and floating point fields
+ * without the parser combinator.
+ *
+ * The recognizer is a small table-driven state machine over the following rules of the grammar (see grammar.cpp):
+ *
+ *   logical: '0' | '1';
+ *   bit_str: /[01]+/;
+ *   int: /-?[0-9]+/;
+ *   float_dec: /-?[0-9]*[.][0-9]+/;
+ *   float_exp: /[+-]?[0-9]+([.][0-9]+)?[eE][+-]?[0-9]+/;
+ *
+ * @author Duncan Mazza
+ */
+
+#include <fast_classify.h>
+
+
+typedef enum {
+    FCC_BIN,    // '0' or '1'
+    FCC_DIGIT,  // '2' through '9'
+    FCC_MINUS,
+    FCC_PLUS,
+    FCC_DOT,
+    FCC_EXP,    // 'e' or 'E'
+    FCC_OTHER,
+} FastCharCls;
+const int NUM_FCC = 7;
+
+typedef enum {
+    FCS_START,
+    FCS_SIGN,       // Leading sign
+    FCS_INT,        // Integer digits
+    FCS_DOT,        // Decimal point after integer digits
+    FCS_FRAC,       // Fractional digits after integer digits
+    FCS_LEAD_DOT,   // Decimal point without integer digits
+    FCS_LEAD_FRAC,  // Fractional digits without integer digits
+    FCS_EXP,        // Exponent marker
+    FCS_EXP_SIGN,   // Exponent sign
+    FCS_EXP_INT,    // Exponent digits
+    FCS_REJECT,     // Not one of the numeric or boolean rules (or possibly a date, time, or datetime)
+} FastClsState;
+const int NUM_FCS = 11;
+
+
+static const FastClsState STATE_TRANS[NUM_FCS][NUM_FCC]{
+        //              BIN            DIGIT          MINUS         PLUS          DOT           EXP          OTHER
+        /* START     */ {FCS_INT,       FCS_INT,       FCS_SIGN,     FCS_SIGN,     FCS_LEAD_DOT, FCS_REJECT,  FCS_REJECT},
+        /* SIGN      */ {FCS_INT,       FCS_INT,       FCS_REJECT,   FCS_REJECT,   FCS_LEAD_DOT, FCS_REJECT,  FCS_REJECT},
+        /* INT       */ {FCS_INT,       FCS_INT,       FCS_REJECT,   FCS_REJECT,   FCS_DOT,      FCS_EXP,     FCS_REJECT},
+        /* DOT       */ {FCS_FRAC,      FCS_FRAC,      FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+        /* FRAC      */ {FCS_FRAC,      FCS_FRAC,      FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_EXP,     FCS_REJECT},
+        /* LEAD_DOT  */ {FCS_LEAD_FRAC, FCS_LEAD_FRAC, FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+        /* LEAD_FRAC */ {FCS_LEAD_FRAC, FCS_LEAD_FRAC, FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+        /* EXP       */ {FCS_EXP_INT,   FCS_EXP_INT,   FCS_EXP_SIGN, FCS_EXP_SIGN, FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+        /* EXP_SIGN  */ {FCS_EXP_INT,   FCS_EXP_INT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+        /* EXP_INT   */ {FCS_EXP_INT,   FCS_EXP_INT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+        /* REJECT    */ {FCS_REJECT,    FCS_REJECT,    FCS_REJECT,   FCS_REJECT,   FCS_REJECT,   FCS_REJECT,  FCS_REJECT},
+};
+
+
+struct FastCharClsTable {
+    unsigned char cls[256];
+
+    FastCharClsTable() : cls() {
+        for (auto &c: cls) c = FCC_OTHER;
+        cls['0'] = cls['1'] = FCC_BIN;
+        for (int c = '2'; c <= '9'; c++) cls[c] = FCC_DIGIT;
+        cls['-'] = FCC_MINUS;
+        cls['+'] = FCC_PLUS;
+        cls['.'] = FCC_DOT;
+        cls['e'] = cls['E'] = FCC_EXP;
+    }
+};
+static const FastCharClsTable CHAR_CLS;
+
+
+int fastClassifyField(const char *const str, size_t len, FieldCls *const ret) {
+    if (len == 0) return 0;
+
+    unsigned state = FCS_START;
+    size_t numNonBinDigits = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned charCls = CHAR_CLS.cls[(unsigned char) str[i]];
+        numNonBinDigits += (charCls == FCC_DIGIT);
+        state = STATE_TRANS[state][charCls];
+    }
+
+    const char sign = str[0];
+    switch (state) {
+        case FCS_INT:
+            if (sign == '+') return 0;  // Only float_exp permits a leading '+'
+            if (sign == '-') {
+                *ret = FC_5_INTEGER;
+                return 1;
+            }
+            // The grammar tries logical and bit_str before any date, time, or datetime rule
+            if (numNonBinDigits == 0) {
+                *ret = len == 1 ? FC_0_LOGICAL : FC_1_BIT_STR;
+                return 1;
+            }
+            // The only digit-only strings that fit a date, time, or datetime rule are 6-digit (e.g., %d%m%y) and 8-digit
+            // (%Y%m%d) dates
+            if (len == 6 || len == 8) return 0;
+            *ret = FC_5_INTEGER;
+            return 1;
+        case FCS_FRAC:
+        case FCS_LEAD_FRAC:
+            if (sign == '+') return 0;
+            *ret = FC_6_FLT_DEC;
+            return 1;
+        case FCS_EXP_INT:
+            *ret = FC_7_FLT_EXP;
+            return 1;
+        default:
+            return 0;
+    }
+}
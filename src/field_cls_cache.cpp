@@ -0,0 +1,62 @@
+/**
+ * Definitions for the cache of the classifications of previously seen field values.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <field_cls_cache.h>
+
+using namespace std;
+
+
+FieldClsCache::FieldClsCache(size_t maxEntries, CacheKeyType keyType) :
+        _maxEntries(maxEntries), _keyType(keyType), _numHits(0), _numMisses(0) {}
+
+
+string_view FieldClsCache::getKey(string_view value) {
+    if (_keyType == CK_VALUE) { return value; }
+    GrammarDfa::get().getShape(value.data(), value.size(), _shape);
+    return _shape;
+}
+
+
+int FieldClsCache::lookup(string_view value, FieldCls *const ret) {
+    auto found = _entries.find(getKey(value));
+    if (found == _entries.end()) {
+        _numMisses++;
+        return 0;
+    }
+    _numHits++;
+    *ret = found->second;
+    return 1;
+}
+
+
+void FieldClsCache::insert(string_view value, FieldCls fieldCls) {
+    if (_entries.size() >= _maxEntries) { return; }
+    string_view key = getKey(value);
+    if (_entries.count(key)) { return; }
+    _keys.emplace_back(key);
+    _entries.emplace(_keys.back(), fieldCls);
+}
+
+
+void FieldClsCache::clear() {
+    _entries.clear();
+    _keys.clear();
+    _numHits = 0;
+    _numMisses = 0;
+}
+
+
+size_t FieldClsCache::getNumEntries() const {
+    return _entries.size();
+}
+
+size_t FieldClsCache::getNumHits() const {
+    return _numHits;
+}
+
+size_t FieldClsCache::getNumMisses() const {
+    return _numMisses;
+}
@@ -12,6 +12,79 @@
 using namespace std;
 
 
+// Note that %p is not usable for date/time input, so this will need to be handled as a special case downstream when
+// parsing times
+const char *const MPC_GRAMMAR =
+        // Date and time rules:
+        "year_4_digit: /[0-9]{4}/;"
+        "year_2_digit: /[0-9]{2}/;"
+        "day: /[0-2][0-9]|30|31/;"
+        "day_single_dig: /[1-9]|[1-9]{2}|30|31|32/;"
+        "month_m: /0[0-9]|10|11|12/;"  // Month using the %m format
+        "month_b: /Jan|Feb|Mar|Apr|May|Jun|Jul|Aug|Sep|Oct|Nov|Dec/;"  // Month using the %b format
+        "month_single_dig: /[1-9]|10|11|12/;"
+        "second: /[0-5][0-9]/;"
+        "minute: /[0-5][0-9]/;"
+        "hour_12: /0[1-9]|10|11|12/;"
+        "hour_24: /[0-1][0-9]|20|21|22|23/;"
+        "hour_12_single_dig: /[1-9]|10|11|12/;"
+        "hour_24_single_dig: /[0-1]|1[0-9]|20|21|22|23/;"
+        "fsecond: /\\.[0-9]+/;"  // Fractional second
+        "apm: /[AP]M/;"  // AM or PM (must be capitalized)
+        "tz_q: /[+-][0-9]{4}/;"  // Time zone using the %q format
+        "tz_Q: /[+-][0-9]{2}:[0-9]{2}/;"  // Time zone using the %Q format
+        "tz_ZP: /[A-Z]{3}[+-][0-9]{2}/;"  // Time zone using the %ZP format
+        "time: <hour_12><minute><second><fsecond>?' '?<apm>(<tz_q> | <tz_Q> | ' '<tz_ZP>)?"
+        "    | (<hour_12> | <hour_12_single_dig>)':'<minute>(':'<second><fsecond>?)?' '?<apm>(<tz_q> | <tz_Q> | ' '<tz_ZP>)?"
+        "    | <hour_24><minute><second><fsecond>?(' '?<apm>)?(<tz_q> | <tz_Q> | ' '<tz_ZP>)"  // If there is a
+        // 6-digit time string, require that it be suffixed by a time zone
+        "    | (<hour_24> | <hour_24_single_dig>)':'<minute>(':'<second><fsecond>?)?(' '?<apm>)?(<tz_q> | <tz_Q> | ' '<tz_ZP>)?;"
+        "date: <year_4_digit><month_m><day>"
+        "    | <month_m><day><year_2_digit>"
+        "    | <day><month_m><year_2_digit>"
+        "    | (<month_m> | <month_b> | <month_single_dig>)('-' | '/')(<day> | <day_single_dig>)('-' | '/')(<year_4_digit> | <year_2_digit>)"
+        "    | <year_4_digit>('-' | '/')(<month_m> | <month_b> | <month_single_dig>)('-' | '/')(<day> | <day_single_dig>);"
+        "datetime: <date>(' ' | 'T')?<time>;"
+
+        // All other rules:
+        "logical: '0' | '1';"  // Logical value
+        "bit_str: /[01]+/;"  // Bit string
+        "int: /-?[0-9]+/;"  // Integer
+        "float_dec: /-?[0-9]*[.][0-9]+/;"  // Decimal floating point
+        "float_exp: /[+-]?[0-9]+([.][0-9]+)?[eE][+-]?[0-9]+/;"  // Scientific notation floating point
+
+        // Put all the rules together here. Though there may be some optimizations to be had about the number of
+        // end/start patterns used here, generally speaking, they are necessary (as opposed to grouping some rules
+        // together and putting start/end patterns around them).
+        "all: /^/<logical>/$/ "
+        "   | /^/<bit_str>/$/ "
+        "   | /^/("
+        "           <datetime> "
+        "         | <time> "
+        "         | <date>"
+        "     )/$/ "
+        "   | /^/<int>/$/ "
+        "   | /^/("
+        "           <float_exp>"
+        "         | <float_dec>"
+        "     )/$/;"
+
+        // Each alternative of `all` on its own (in the same order), so that a field can be tested against one
+        // group of classifications without trying the alternatives before it
+        "all_logical: /^/<logical>/$/;"
+        "all_bit_str: /^/<bit_str>/$/;"
+        "all_dt: /^/("
+        "           <datetime> "
+        "         | <time> "
+        "         | <date>"
+        "     )/$/;"
+        "all_int: /^/<int>/$/;"
+        "all_float: /^/("
+        "           <float_exp>"
+        "         | <float_dec>"
+        "     )/$/;";
+
+
 string mpc_strip_tag(const string &tag) {
     size_t vbar_pos = tag.find('|');
     if (vbar_pos == string::npos) {
@@ -21,63 +94,29 @@ string mpc_strip_tag(const string &tag) {
 }
 
 
-void mpc_setup(mpc_parser_t **parser, vector<mpc_parser_t *> &allParsers) {
-    // Note that %p is not usable for date/time input, so this will need to be handled as a special case downstream
-    // when parsing times
-    const char *grammar =
-            // Date and time rules:
-            "year_4_digit: /[0-9]{4}/;"
-            "year_2_digit: /[0-9]{2}/;"
-            "day: /[0-2][0-9]|30|31/;"
-            "day_single_dig: /[1-9]|[1-9]{2}|30|31|32/;"
-            "month_m: /0[0-9]|10|11|12/;"  // Month using the %m format
-            "month_b: /Jan|Feb|Mar|Apr|May|Jun|Jul|Aug|Sep|Oct|Nov|Dec/;"  // Month using the %b format
-            "month_single_dig: /[1-9]|10|11|12/;"
-            "second: /[0-5][0-9]/;"
-            "minute: /[0-5][0-9]/;"
-            "hour_12: /0[1-9]|10|11|12/;"
-            "hour_24: /[0-1][0-9]|20|21|22|23/;"
-            "hour_12_single_dig: /[1-9]|10|11|12/;"
-            "hour_24_single_dig: /[0-1]|1[0-9]|20|21|22|23/;"
-            "fsecond: /\\.[0-9]+/;"  // Fractional second
-            "apm: /[AP]M/;"  // AM or PM (must be capitalized)
-            "tz_q: /[+-][0-9]{4}/;"  // Time zone using the %q format
-            "tz_Q: /[+-][0-9]{2}:[0-9]{2}/;"  // Time zone using the %Q format
-            "tz_ZP: /[A-Z]{3}[+-][0-9]{2}/;"  // Time zone using the %ZP format
-            "time: <hour_12><minute><second><fsecond>?' '?<apm>(<tz_q> | <tz_Q> | ' '<tz_ZP>)?"
-            "    | (<hour_12> | <hour_12_single_dig>)':'<minute>(':'<second><fsecond>?)?' '?<apm>(<tz_q> | <tz_Q> | ' '<tz_ZP>)?"
-            "    | <hour_24><minute><second><fsecond>?(' '?<apm>)?(<tz_q> | <tz_Q> | ' '<tz_ZP>)"  // If there is a
-            // 6-digit time string, require that it be suffixed by a time zone
-            "    | (<hour_24> | <hour_24_single_dig>)':'<minute>(':'<second><fsecond>?)?(' '?<apm>)?(<tz_q> | <tz_Q> | ' '<tz_ZP>)?;"
-            "date: <year_4_digit><month_m><day>"
-            "    | <month_m><day><year_2_digit>"
-            "    | <day><month_m><year_2_digit>"
-            "    | (<month_m> | <month_b> | <month_single_dig>)('-' | '/')(<day> | <day_single_dig>)('-' | '/')(<year_4_digit> | <year_2_digit>)"
-            "    | <year_4_digit>('-' | '/')(<month_m> | <month_b> | <month_single_dig>)('-' | '/')(<day> | <day_single_dig>);"
-            "datetime: <date>(' ' | 'T')?<time>;"
-
-            // All other rules:
-            "logical: '0' | '1';"  // Logical value
-            "bit_str: /[01]+/;"  // Bit string
-            "int: /-?[0-9]+/;"  // Integer
-            "float_dec: /-?[0-9]*[.][0-9]+/;"  // Decimal floating point
-            "float_exp: /[+-]?[0-9]+([.][0-9]+)?[eE][+-]?[0-9]+/;"  // Scientific notation floating point
-
-            // Put all the rules together here. Though there may be some optimizations to be had about the number of
-            // end/start patterns used here, generally speaking, they are necessary (as opposed to grouping some rules
-            // together and putting start/end patterns around them).
-            "all: /^/<logical>/$/ "
-            "   | /^/<bit_str>/$/ "
-            "   | /^/("
-            "           <datetime> "
-            "         | <time> "
-            "         | <date>"
-            "     )/$/ "
-            "   | /^/<int>/$/ "
-            "   | /^/("
-            "           <float_exp>"
-            "         | <float_dec>"
-            "     )/$/;";
+void getGrammarRules(vector<tuple<string, string>> &ret) {
+    // No rule contains a semicolon other than the one that ends it
+    string rule;
+    for (const char *c = MPC_GRAMMAR; *c; c++) {
+        if (*c != ';') {
+            // Collapse each run of whitespace into one space, so that rules can be compared regardless of line breaks
+            if (!isspace((unsigned char) *c)) {
+                rule += *c;
+            } else if (!rule.empty() && rule.back() != ' ') {
+                rule += ' ';
+            }
+            continue;
+        }
+        if (!rule.empty() && rule.back() == ' ') rule.pop_back();
+        size_t colonPos = rule.find(':');
+        size_t definitionStart = rule.find_first_not_of(' ', colonPos + 1);
+        ret.emplace_back(rule.substr(0, colonPos), rule.substr(definitionStart));
+        rule.clear();
+    }
+}
+
+
+void mpc_setup(mpc_parser_t **parser, vector<mpc_parser_t *> &allParsers, mpc_parser_t **groupParsers) {
 
     // mpc only allows this method of creating a language parser through a variadic function, so manually create every
     // parser needed in the scope.
@@ -108,10 +147,23 @@ void mpc_setup(mpc_parser_t **parser, vector<mpc_parser_t *> &allParsers) {
     mpc_parser_t *p25 = mpc_new("float_dec");
     mpc_parser_t *p26 = mpc_new("float_exp");
     mpc_parser_t *p27 = mpc_new("all");
+    mpc_parser_t *p28 = mpc_new("all_logical");
+    mpc_parser_t *p29 = mpc_new("all_bit_str");
+    mpc_parser_t *p30 = mpc_new("all_dt");
+    mpc_parser_t *p31 = mpc_new("all_int");
+    mpc_parser_t *p32 = mpc_new("all_float");
 
-    mpca_lang(MPCA_LANG_WHITESPACE_SENSITIVE, grammar, p01, p02, p03, p04, p05, p06, p07, p08, p09, p10,
-              p11, p12, p13, p14, p15, p16, p17, p18, p19, p20, p21, p22, p23, p24, p25, p26, p27, NULL);
+    mpca_lang(MPCA_LANG_WHITESPACE_SENSITIVE, MPC_GRAMMAR, p01, p02, p03, p04, p05, p06, p07, p08, p09, p10,
+              p11, p12, p13, p14, p15, p16, p17, p18, p19, p20, p21, p22, p23, p24, p25, p26, p27, p28, p29, p30,
+              p31, p32, NULL);
     *parser = p27;
+    if (groupParsers != nullptr) {
+        groupParsers[GG_LOGICAL] = p28;
+        groupParsers[GG_BIT_STR] = p29;
+        groupParsers[GG_DT] = p30;
+        groupParsers[GG_INT] = p31;
+        groupParsers[GG_FLOAT] = p32;
+    }
 
     allParsers.push_back(p01);
     allParsers.push_back(p02);
@@ -140,4 +192,9 @@ void mpc_setup(mpc_parser_t **parser, vector<mpc_parser_t *> &allParsers) {
     allParsers.push_back(p25);
     allParsers.push_back(p26);
     allParsers.push_back(p27);
+    allParsers.push_back(p28);
+    allParsers.push_back(p29);
+    allParsers.push_back(p30);
+    allParsers.push_back(p31);
+    allParsers.push_back(p32);
 }
@@ -0,0 +1,680 @@
+/**
+ * Definitions for the deterministic finite automaton compiled from the classification grammar.
+ *
+ * The rules of `MPC_GRAMMAR` (and the regexes within them) are parsed into syntax trees, which are built into a
+ * Thompson NFA (one fragment per use of a rule). The bytes are then partitioned into classes that every character set
+ * of the grammar treats identically, and the NFA is determinized with the subset construction.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <grammar_dfa.h>
+#include <grammar.h>
+#include <algorithm>
+#include <bitset>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace std;
+
+
+// Largest number of strings of an alternative that are listed to find those that mpc can't reach
+const size_t MAX_PRUNED_STRINGS = 1024;
+
+
+/**
+ * Kinds of nodes of the syntax tree of a rule (in the language of `mpca_lang`) or of a regex within a rule.
+ */
+typedef enum {
+    GN_CHARS,  // One byte of a set
+    GN_SEQ,  // The children one after another
+    GN_ALT,  // One of the children, tried in order
+    GN_OPT,  // The child or nothing
+    GN_STAR,  // The child any number of times
+    GN_PLUS,  // The child at least once
+    GN_RULE,  // Another rule of the grammar
+    GN_ANCHOR,  // Start or end of the input (the automaton always matches whole strings, so this matches nothing)
+} GrammarNodeKind;
+
+struct GrammarNode {
+    GrammarNodeKind kind;
+    bitset<256> chars;  // For GN_CHARS
+    string ruleName;  // For GN_RULE
+    vector<GrammarNode> children;
+};
+
+
+/**
+ * Recursive descent parser for the definition of a rule of the grammar, including the regexes within it. Only the
+ * syntax used by `MPC_GRAMMAR` is supported: rule references, character and string literals, regexes (with character
+ * classes, escapes, groups, alternatives, and the `?`, `*`, `+`, and `{n}` operators), groups, alternatives, and the
+ * `?`, `*`, and `+` operators.
+ */
+class GrammarParser {
+private:
+    const string &_str;
+    size_t _pos;
+    bool _failed;
+
+    int peek() const {
+        return _pos < _str.size() ? (unsigned char) _str[_pos] : -1;
+    }
+
+    void skipSpaces() {
+        while (peek() == ' ') _pos++;
+    }
+
+    void fail() {
+        _failed = true;
+        _pos = _str.size();
+    }
+
+    /**
+     * @return The only child of a sequence or group of alternatives that has one child, or else the node itself.
+     */
+    static GrammarNode unwrap(GrammarNode node) {
+        if ((node.kind == GN_SEQ || node.kind == GN_ALT) && node.children.size() == 1) {
+            return std::move(node.children[0]);
+        }
+        return node;
+    }
+
+    static GrammarNode makeChars(unsigned char c) {
+        GrammarNode ret{GN_CHARS, {}, "", {}};
+        ret.chars.set(c);
+        return ret;
+    }
+
+    /**
+     * Parse the postfix operators after a node (and, in regexes, counted repetitions).
+     */
+    GrammarNode parsePostfix(GrammarNode node, bool regex) {
+        while (true) {
+            const int c = peek();
+            if (c == '?' || c == '*' || c == '+') {
+                _pos++;
+                node = {c == '?' ? GN_OPT : c == '*' ? GN_STAR : GN_PLUS, {}, "", {node}};
+            } else if (regex && c == '{') {
+                const size_t close = _str.find('}', _pos);
+                if (close == string::npos) {
+                    fail();
+                    break;
+                }
+                const string count = _str.substr(_pos + 1, close - _pos - 1);
+                if (count.empty() || count.find_first_not_of("0123456789") != string::npos) {
+                    fail();
+                    break;
+                }
+                _pos = close + 1;
+                node = {GN_SEQ, {}, "", vector<GrammarNode>(stoul(count), node)};
+            } else {
+                break;
+            }
+        }
+        return node;
+    }
+
+    GrammarNode parseRegexClass() {
+        GrammarNode ret{GN_CHARS, {}, "", {}};
+        const bool negated = peek() == '^';
+        if (negated) _pos++;
+        while (peek() != ']') {
+            int c = peek();
+            if (c == -1) {
+                fail();
+                return ret;
+            }
+            _pos++;
+            if (c == '\\' && peek() != -1) c = (unsigned char) _str[_pos++];
+            int hi = c;
+            if (peek() == '-' && _pos + 1 < _str.size() && _str[_pos + 1] != ']') {
+                hi = (unsigned char) _str[_pos + 1];
+                _pos += 2;
+            }
+            for (int member = c; member <= hi; member++) ret.chars.set(member);
+        }
+        _pos++;
+        if (negated) ret.chars.flip();
+        return ret;
+    }
+
+    GrammarNode parseRegexAlt() {
+        GrammarNode ret{GN_ALT, {}, "", {}};
+        while (true) {
+            GrammarNode seq{GN_SEQ, {}, "", {}};
+            while (peek() != -1 && peek() != '|' && peek() != ')' && peek() != '/') {
+                const int c = peek();
+                _pos++;
+                GrammarNode atom;
+                if (c == '(') {
+                    atom = parseRegexAlt();
+                    if (peek() != ')') {
+                        fail();
+                        break;
+                    }
+                    _pos++;
+                } else if (c == '[') {
+                    atom = parseRegexClass();
+                } else if (c == '\\' && peek() != -1) {
+                    atom = makeChars((unsigned char) _str[_pos++]);
+                } else if (c == '^' || c == '$') {
+                    atom = {GN_ANCHOR, {}, "", {}};
+                } else if (c == '.') {
+                    atom = {GN_CHARS, {}, "", {}};
+                    atom.chars.set();
+                    atom.chars.reset('\n');
+                } else {
+                    atom = makeChars((unsigned char) c);
+                }
+                seq.children.push_back(parsePostfix(atom, true));
+            }
+            ret.children.push_back(unwrap(std::move(seq)));
+            if (peek() != '|') { return unwrap(std::move(ret)); }
+            _pos++;
+        }
+    }
+
+    GrammarNode parseLiteral(char quote) {
+        GrammarNode ret{GN_SEQ, {}, "", {}};
+        while (peek() != quote) {
+            int c = peek();
+            if (c == -1) {
+                fail();
+                return ret;
+            }
+            _pos++;
+            if (c == '\\' && peek() != -1) c = (unsigned char) _str[_pos++];
+            ret.children.push_back(makeChars((unsigned char) c));
+        }
+        _pos++;
+        return ret;
+    }
+
+    GrammarNode parseAlt() {
+        GrammarNode ret{GN_ALT, {}, "", {}};
+        while (true) {
+            GrammarNode seq{GN_SEQ, {}, "", {}};
+            skipSpaces();
+            while (peek() != -1 && peek() != '|' && peek() != ')') {
+                const int c = peek();
+                _pos++;
+                GrammarNode atom;
+                if (c == '<') {
+                    const size_t close = _str.find('>', _pos);
+                    if (close == string::npos) {
+                        fail();
+                        break;
+                    }
+                    atom = {GN_RULE, {}, _str.substr(_pos, close - _pos), {}};
+                    _pos = close + 1;
+                } else if (c == '\'' || c == '"') {
+                    atom = parseLiteral((char) c);
+                } else if (c == '/') {
+                    atom = parseRegexAlt();
+                    if (peek() != '/') {
+                        fail();
+                        break;
+                    }
+                    _pos++;
+                } else if (c == '(') {
+                    atom = parseAlt();
+                    if (peek() != ')') {
+                        fail();
+                        break;
+                    }
+                    _pos++;
+                } else {
+                    fail();
+                    break;
+                }
+                seq.children.push_back(parsePostfix(atom, false));
+                skipSpaces();
+            }
+            ret.children.push_back(unwrap(std::move(seq)));
+            if (peek() != '|') { return unwrap(std::move(ret)); }
+            _pos++;
+        }
+    }
+
+public:
+    explicit GrammarParser(const string &str) : _str(str), _pos(0), _failed(false) {}
+
+    /**
+     * @return Whether the whole definition was parsed into `ret`.
+     */
+    bool parse(GrammarNode &ret) {
+        ret = parseAlt();
+        return !_failed && _pos == _str.size();
+    }
+};
+
+
+struct NfaState {
+    vector<int> epsilon;
+    bitset<256> chars;
+    int charNext = -1;  // State reached by consuming a byte in `chars` (-1 if none)
+    int acceptIdx = -1;  // Index of the alternative of `all` accepted in this state (-1 if none)
+};
+
+struct NfaFrag {
+    int start;
+    int end;
+};
+
+
+/**
+ * Builder for the Thompson NFA of the grammar. Every use of a rule creates a new fragment, as NFA fragments can't be
+ * shared between the places that a rule is used.
+ *
+ * @note mpc tries the alternatives of a rule (and of a regex) in order and commits to the first one that matches, so a
+ *  string of an alternative can never be matched if an earlier alternative matches a prefix of it (e.g., the strings of
+ *  `[1-9]{2}` in `day_single_dig`, as `[1-9]` always matches first). Such strings are left out, for alternatives whose
+ *  strings can be listed (i.e., that match fewer than `MAX_PRUNED_STRINGS` strings).
+ */
+class GrammarNfa {
+private:
+    const map<string, GrammarNode> &_rules;
+
+    /**
+     * List the strings that a node matches (after leaving out the strings of alternatives that can't be reached).
+     *
+     * @return Whether the node matches fewer than `MAX_PRUNED_STRINGS` strings, in which case they are set in `ret`.
+     */
+    bool getStrings(const GrammarNode &node, vector<string> &ret) const {
+        ret.clear();
+        switch (node.kind) {
+            case GN_CHARS:
+                for (int c = 0; c < 256; c++) {
+                    if (node.chars.test(c)) ret.emplace_back(1, (char) c);
+                }
+                return ret.size() < MAX_PRUNED_STRINGS;
+            case GN_ANCHOR:
+                ret.emplace_back();
+                return true;
+            case GN_SEQ: {
+                ret.emplace_back();
+                vector<string> childStrings;
+                for (const auto &child: node.children) {
+                    if (!getStrings(child, childStrings) ||
+                        ret.size() * childStrings.size() >= MAX_PRUNED_STRINGS) {
+                        return false;
+                    }
+                    vector<string> product;
+                    for (const auto &prefix: ret) {
+                        for (const auto &suffix: childStrings) product.push_back(prefix + suffix);
+                    }
+                    ret = std::move(product);
+                }
+                break;
+            }
+            case GN_ALT: {
+                vector<vector<string>> altStrings;
+                vector<size_t> numStrings;
+                if (!getReachableStrings(node, altStrings, numStrings)) { return false; }
+                for (const auto &strings: altStrings) ret.insert(ret.end(), strings.begin(), strings.end());
+                break;
+            }
+            case GN_OPT:
+                if (!getStrings(node.children[0], ret)) { return false; }
+                ret.emplace_back();
+                break;
+            case GN_RULE:
+                return getStrings(_rules.at(node.ruleName), ret);
+            default:
+                return false;
+        }
+        sort(ret.begin(), ret.end());
+        ret.erase(unique(ret.begin(), ret.end()), ret.end());
+        return ret.size() < MAX_PRUNED_STRINGS;
+    }
+
+    /**
+     * List the strings of each alternative that no earlier alternative matches a prefix of.
+     *
+     * @param ret Set to the strings of each alternative that can be reached (empty for alternatives whose strings
+     *  can't be listed, which are kept whole)
+     * @param numStrings Set to the number of strings of each alternative, or to `MAX_PRUNED_STRINGS` if they can't be
+     *  listed
+     * @return Whether the strings of every alternative could be listed.
+     */
+    bool getReachableStrings(const GrammarNode &node, vector<vector<string>> &ret, vector<size_t> &numStrings) const {
+        ret.assign(node.children.size(), {});
+        numStrings.assign(node.children.size(), MAX_PRUNED_STRINGS);
+        bool listed = true;
+        for (size_t altIdx = 0; altIdx < node.children.size(); altIdx++) {
+            vector<string> strings;
+            if (!getStrings(node.children[altIdx], strings)) {
+                listed = false;
+                continue;
+            }
+            numStrings[altIdx] = strings.size();
+            for (const auto &str: strings) {
+                bool reachable = true;
+                for (size_t prevAltIdx = 0; prevAltIdx < altIdx && reachable; prevAltIdx++) {
+                    for (const auto &prevStr: ret[prevAltIdx]) {
+                        if (str.compare(0, prevStr.size(), prevStr) == 0) {
+                            reachable = false;
+                            break;
+                        }
+                    }
+                }
+                if (reachable) ret[altIdx].push_back(str);
+            }
+        }
+        return listed;
+    }
+
+    NfaFrag lit(const string &str) {
+        int start = newState();
+        int end = start;
+        for (const char c: str) {
+            int next = newState();
+            states[end].chars.set((unsigned char) c);
+            states[end].charNext = next;
+            end = next;
+        }
+        return {start, end};
+    }
+
+    NfaFrag seq(const vector<NfaFrag> &frags) {
+        if (frags.empty()) { return lit(""); }
+        NfaFrag ret = frags[0];
+        for (size_t fragIdx = 1; fragIdx < frags.size(); fragIdx++) {
+            states[ret.end].epsilon.push_back(frags[fragIdx].start);
+            ret.end = frags[fragIdx].end;
+        }
+        return ret;
+    }
+
+    NfaFrag alt(const vector<NfaFrag> &frags) {
+        int start = newState();
+        int end = newState();
+        for (const auto &frag: frags) {
+            states[start].epsilon.push_back(frag.start);
+            states[frag.end].epsilon.push_back(end);
+        }
+        return {start, end};
+    }
+
+    NfaFrag opt(NfaFrag frag) {
+        int start = newState();
+        int end = newState();
+        states[start].epsilon.push_back(frag.start);
+        states[start].epsilon.push_back(end);
+        states[frag.end].epsilon.push_back(end);
+        return {start, end};
+    }
+
+    NfaFrag plus(NfaFrag frag) {
+        int end = newState();
+        states[frag.end].epsilon.push_back(frag.start);
+        states[frag.end].epsilon.push_back(end);
+        return {frag.start, end};
+    }
+
+public:
+    vector<NfaState> states;
+
+    explicit GrammarNfa(const map<string, GrammarNode> &rules) : _rules(rules) {}
+
+    int newState() {
+        states.emplace_back();
+        return (int) states.size() - 1;
+    }
+
+    NfaFrag build(const GrammarNode &node) {
+        vector<NfaFrag> frags;
+        switch (node.kind) {
+            case GN_CHARS: {
+                int start = newState();
+                int end = newState();
+                states[start].chars = node.chars;
+                states[start].charNext = end;
+                return {start, end};
+            }
+            case GN_SEQ:
+                for (const auto &child: node.children) frags.push_back(build(child));
+                return seq(frags);
+            case GN_ALT: {
+                // Alternatives of which no string can be reached are left out, and those of which only some strings
+                // can be reached are replaced by those strings
+                vector<vector<string>> altStrings;
+                vector<size_t> numStrings;
+                getReachableStrings(node, altStrings, numStrings);
+                for (size_t altIdx = 0; altIdx < node.children.size(); altIdx++) {
+                    if (numStrings[altIdx] == MAX_PRUNED_STRINGS || altStrings[altIdx].size() == numStrings[altIdx]) {
+                        frags.push_back(build(node.children[altIdx]));
+                        continue;
+                    }
+                    for (const auto &str: altStrings[altIdx]) frags.push_back(lit(str));
+                }
+                return alt(frags);
+            }
+            case GN_OPT:
+                return opt(build(node.children[0]));
+            case GN_STAR:
+                return opt(plus(build(node.children[0])));
+            case GN_PLUS:
+                return plus(build(node.children[0]));
+            case GN_RULE:
+                return build(_rules.at(node.ruleName));
+            case GN_ANCHOR:
+                return lit("");
+        }
+        return lit("");
+    }
+};
+
+
+/**
+ * Find the classification given by each alternative of the `all` rule, which is an alternative of `all` with the
+ * anchors around it taken away: either a rule named in `FieldClsCorrespondingNames` or a group of such alternatives.
+ *
+ * @param ret Vector to which a tuple of each alternative and its classification is appended (in order)
+ * @return Whether the node has this form.
+ */
+static bool getClassifiedAlternatives(const GrammarNode &node, vector<tuple<const GrammarNode *, FieldCls>> &ret) {
+    switch (node.kind) {
+        case GN_RULE:
+            for (int i = 0; i < NUM_FC - 1; i++) {
+                if (node.ruleName == FieldClsCorrespondingNames[i]) {
+                    ret.emplace_back(&node, (FieldCls) i);
+                    return true;
+                }
+            }
+            return false;
+        case GN_ALT:
+            for (const auto &child: node.children) {
+                if (!getClassifiedAlternatives(child, ret)) { return false; }
+            }
+            return true;
+        case GN_SEQ: {
+            const GrammarNode *inner = nullptr;
+            for (const auto &child: node.children) {
+                if (child.kind == GN_ANCHOR) { continue; }
+                if (inner != nullptr) { return false; }
+                inner = &child;
+            }
+            return inner != nullptr && getClassifiedAlternatives(*inner, ret);
+        }
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @return Whether every rule that a node refers to is defined (rules can't refer to themselves, directly or not, as the
+ *  automaton could then not be finite).
+ */
+static bool refersToDefinedRules(const GrammarNode &node, const map<string, GrammarNode> &rules, size_t depth = 0) {
+    if (node.kind == GN_RULE) {
+        auto found = rules.find(node.ruleName);
+        return found != rules.end() && depth < rules.size() && refersToDefinedRules(found->second, rules, depth + 1);
+    }
+    for (const auto &child: node.children) {
+        if (!refersToDefinedRules(child, rules, depth)) { return false; }
+    }
+    return true;
+}
+
+
+static void epsilonClosure(const vector<NfaState> &states, vector<int> &set) {
+    vector<char> inSet(states.size(), 0);
+    vector<int> stack(set);
+    for (int s: set) inSet[s] = 1;
+    while (!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        for (int next: states[s].epsilon) {
+            if (inSet[next]) continue;
+            inSet[next] = 1;
+            set.push_back(next);
+            stack.push_back(next);
+        }
+    }
+    sort(set.begin(), set.end());
+}
+
+
+GrammarDfa::GrammarDfa() : _byteCls(), _numByteCls(0), _startState(0) {
+    // Parse every rule of the grammar and find the alternatives of `all`
+    vector<tuple<string, string>> grammarRules;
+    getGrammarRules(grammarRules);
+    map<string, GrammarNode> rules;
+    for (const auto &rule: grammarRules) {
+        if (!GrammarParser(std::get<1>(rule)).parse(rules[std::get<0>(rule)])) {
+            cerr << "Could not compile rule " << std::get<0>(rule) << " of the grammar into an automaton" << endl;
+            rules.clear();
+            break;
+        }
+    }
+    vector<tuple<const GrammarNode *, FieldCls>> alternatives;
+    if (rules.count("all") && (!refersToDefinedRules(rules.at("all"), rules) ||
+                               !getClassifiedAlternatives(rules.at("all"), alternatives))) {
+        cerr << "The `all` rule of the grammar refers to undefined rules or has an alternative without a classification"
+             << endl;
+        alternatives.clear();
+    }
+
+    // Each alternative ends in a state that accepts it
+    GrammarNfa nfa(rules);
+    int nfaStart = nfa.newState();
+    for (size_t altIdx = 0; altIdx < alternatives.size(); altIdx++) {
+        NfaFrag frag = nfa.build(*std::get<0>(alternatives[altIdx]));
+        nfa.states[nfaStart].epsilon.push_back(frag.start);
+        nfa.states[frag.end].acceptIdx = (int) altIdx;
+    }
+    const vector<NfaState> &states = nfa.states;
+
+    // Partition the bytes into classes such that bytes in the same class are in exactly the same character sets
+    map<string, unsigned char> signatureToCls;
+    vector<bitset<256>> charSets;
+    for (const auto &state: states) {
+        if (state.charNext != -1 && find(charSets.begin(), charSets.end(), state.chars) == charSets.end()) {
+            charSets.push_back(state.chars);
+        }
+    }
+    vector<int> clsRepresentative;
+    for (int c = 0; c < 256; c++) {
+        string signature(charSets.size(), '0');
+        for (size_t i = 0; i < charSets.size(); i++) {
+            if (charSets[i].test(c)) signature[i] = '1';
+        }
+        auto found = signatureToCls.find(signature);
+        if (found == signatureToCls.end()) {
+            found = signatureToCls.emplace(signature, (unsigned char) clsRepresentative.size()).first;
+            clsRepresentative.push_back(c);
+        }
+        _byteCls[c] = found->second;
+    }
+    _numByteCls = clsRepresentative.size();
+
+    // Subset construction; the empty set of NFA states is the dead state 0
+    map<vector<int>, uint32_t> setToState;
+    vector<vector<int>> stateSets;
+    auto addState = [&](vector<int> &set) -> uint32_t {
+        auto found = setToState.find(set);
+        if (found != setToState.end()) return found->second;
+        auto newState = (uint32_t) stateSets.size();
+        setToState.emplace(set, newState);
+        stateSets.push_back(set);
+
+        // When a string fits more than one alternative of `all`, mpc gives it the classification of the earliest one
+        int acceptIdx = -1;
+        for (int s: set) {
+            if (states[s].acceptIdx != -1 && (acceptIdx == -1 || states[s].acceptIdx < acceptIdx)) {
+                acceptIdx = states[s].acceptIdx;
+            }
+        }
+        _stateCls.push_back((unsigned char) (acceptIdx == -1 ? FC_8_ARBITRY : std::get<1>(alternatives[acceptIdx])));
+        _trans.resize(_trans.size() + _numByteCls, 0);
+        return newState;
+    };
+
+    vector<int> deadSet;
+    addState(deadSet);
+    vector<int> startSet{nfaStart};
+    epsilonClosure(states, startSet);
+    _startState = addState(startSet);
+
+    for (uint32_t dfaState = 1; dfaState < stateSets.size(); dfaState++) {
+        for (size_t cls = 0; cls < _numByteCls; cls++) {
+            int representative = clsRepresentative[cls];
+            vector<int> nextSet;
+            for (int s: stateSets[dfaState]) {
+                if (states[s].charNext != -1 && states[s].chars.test(representative)) {
+                    nextSet.push_back(states[s].charNext);
+                }
+            }
+            if (nextSet.empty()) continue;
+            epsilonClosure(states, nextSet);
+            uint32_t nextState = addState(nextSet);
+            _trans[dfaState * _numByteCls + cls] = nextState;
+        }
+    }
+}
+
+
+const GrammarDfa &GrammarDfa::get() {
+    static const GrammarDfa dfa;
+    return dfa;
+}
+
+
+FieldCls GrammarDfa::classify(const char *const str, size_t len) const {
+    uint32_t state = _startState;
+    for (size_t i = 0; i < len && state != 0; i++) {
+        state = _trans[state * _numByteCls + _byteCls[(unsigned char) str[i]]];
+    }
+    return (FieldCls) _stateCls[state];
+}
+
+
+void GrammarDfa::getShape(const char *const str, size_t len, string &ret) const {
+    ret.clear();
+    size_t runStart = 0;
+    for (size_t i = 1; i <= len; i++) {
+        if (i < len && _byteCls[(unsigned char) str[i]] == _byteCls[(unsigned char) str[runStart]]) {
+            continue;
+        }
+        ret += (char) _byteCls[(unsigned char) str[runStart]];
+        size_t runLen = i - runStart;
+        for (; runLen >= 0x80; runLen >>= 7) {
+            ret += (char) (0x80 | (runLen & 0x7f));
+        }
+        ret += (char) runLen;
+        runStart = i;
+    }
+}
+
+
+size_t GrammarDfa::getNumStates() const {
+    return _stateCls.size();
+}
+
+size_t GrammarDfa::getNumByteClasses() const {
+    return _numByteCls;
+}
+
@@ -0,0 +1,247 @@
+/**
+ * Definitions for incrementally classifying data files that are appended to.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+#include <hash.h>
+#include <pod_io.h>
+#include <tokenizer.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+const size_t TAIL_PREFIX_LEN = 4096;
+const size_t TAIL_MIN_TRUSTED_ROWS = 8;
+const char TAIL_STATE_MAGIC[8]{'T', 'D', 'I', 'T', 'A', 'I', 'L', '1'};
+
+
+/**
+ * @return The hash of the first `min(len, TAIL_PREFIX_LEN)` bytes of the file, or 0 if they could not be read.
+ */
+static uint64_t getPrefixHash(int fd, size_t len) {
+    string prefix(std::min(len, TAIL_PREFIX_LEN), '\0');
+    if (pread(fd, prefix.data(), prefix.size(), 0) != (ssize_t) prefix.size()) { return 0; }
+    return fnv1aHash(prefix.data(), prefix.size());
+}
+
+
+static void getTailClassifications(const TailState &state, vector<tuple<string, FieldCls>> &classifications) {
+    classifications.clear();
+    for (size_t columnIdx = 0; columnIdx < state.columnNames.size(); columnIdx++) {
+        classifications.emplace_back(state.columnNames[columnIdx], state.fieldClasses[columnIdx]);
+    }
+}
+
+
+/**
+ * Classify the complete lines of the whole file and reset the state to the result.
+ */
+static int scanWholeFile(const string &path, TailState &state, MpcParserTWrapper &parser,
+                         InferenceStats *const stats) {
+    state.established = 0;
+    state.offset = 0;
+    state.columnNames.clear();
+    state.fieldClasses.clear();
+
+    MappedFile file;
+    vector<string_view> lines;
+    if (!mapFileLines(path, file, lines, stats)) { return 0; }
+
+    // A partial trailing line is left for a later call, once the rest of it has been written
+    const size_t lastNewline = file.view().rfind('\n');
+    const string_view buffer = file.view().substr(0, lastNewline == string_view::npos ? 0 : lastNewline + 1);
+    if (!lines.empty() && buffer.size() < file.view().size()) {
+        lines.pop_back();
+    }
+
+    // A header alone (or any single line) has no consistency to find a delimiter from, and freezing it would make every
+    // appended line a single arbitrary field, so the state is left unestablished for the next call to rescan
+    tuple<char, size_t> delimRet;
+    vector<tuple<string, FieldCls>> classifications;
+    size_t numRows;
+    const int consistentFields = classifyLines(lines, delimRet, classifications, parser, &numRows, stats);
+    if (get<0>(delimRet) == '\0' || numRows < 2) { return 0; }
+
+    for (const auto &classification: classifications) {
+        state.columnNames.push_back(get<0>(classification));
+        state.fieldClasses.push_back(get<1>(classification));
+    }
+    state.established = 1;
+    state.offset = buffer.size();
+    state.prefixHash = fnv1aHash(buffer.data(), std::min(buffer.size(), TAIL_PREFIX_LEN));
+    state.delim = get<0>(delimRet);
+    state.headerLineIdx = get<1>(delimRet);
+    state.consistentFields = consistentFields == 1;
+    state.numRows = numRows - 1;
+    return 1;
+}
+
+
+/**
+ * Classify the complete lines appended since the offset of the state and fold them into the state.
+ */
+static int scanAppended(int fd, size_t fileSize, TailState &state, MpcParserTWrapper &parser,
+                        InferenceStats *const stats) {
+    string buffer;
+    vector<string_view> lines;
+    {
+        PhaseTimer timer(stats, IP_READ);
+        buffer.resize(fileSize - state.offset);
+        if (pread(fd, buffer.data(), buffer.size(), (off_t) state.offset) != (ssize_t) buffer.size()) { return 0; }
+        buffer.resize(buffer.rfind('\n') == string::npos ? 0 : buffer.rfind('\n') + 1);
+        getBufferLines(buffer, lines);
+        if (stats != nullptr) {
+            stats->linesScanned[IP_READ] += lines.size();
+            stats->bytesScanned[IP_READ] += buffer.size();
+        }
+    }
+
+    {
+        PhaseTimer timer(stats, IP_CLASSIFY);
+        vector<FieldBounds> bounds;
+        for (const auto &line: lines) {
+            if (line.empty()) { continue; }
+            bounds.clear();
+            tokenizeRecord(line.data(), line.size(), state.delim, bounds);
+            if (bounds.size() != state.fieldClasses.size()) {
+                state.consistentFields = 0;
+            }
+            const size_t numFields = std::min(bounds.size(), state.fieldClasses.size());
+            for (size_t fieldIdx = 0; fieldIdx < numFields; fieldIdx++) {
+                const string_view field = line.substr(bounds[fieldIdx].start,
+                                                      bounds[fieldIdx].end - bounds[fieldIdx].start);
+                state.fieldClasses[fieldIdx] = classifyFieldInColumn(field, state.fieldClasses[fieldIdx], parser,
+                                                                     CE_MPC, nullptr, stats);
+            }
+            state.numRows++;
+        }
+    }
+
+    // The hashed prefix grows with the file until it reaches its full length
+    const size_t prevOffset = state.offset;
+    state.offset += buffer.size();
+    if (prevOffset < TAIL_PREFIX_LEN && state.offset > prevOffset) {
+        state.prefixHash = getPrefixHash(fd, state.offset);
+    }
+    return 1;
+}
+
+
+int classifyFileIncremental(const string &path, TailState &state, vector<tuple<string, FieldCls>> &classifications,
+                            MpcParserTWrapper &parser, bool *const fullScan, InferenceStats *const stats) {
+    if (fullScan != nullptr) {
+        *fullScan = false;
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Could not open file " << path << endl;
+        return 0;
+    }
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 0;
+    }
+    const auto fileSize = (size_t) fileStat.st_size;
+
+    // The delimiter and header found from only a few rows are not trusted until enough rows have been seen
+    const bool rescan = !state.established || state.numRows < TAIL_MIN_TRUSTED_ROWS ||
+                        state.device != (uint64_t) fileStat.st_dev ||
+                        state.inode != (uint64_t) fileStat.st_ino || fileSize < state.offset ||
+                        getPrefixHash(fd, state.offset) != state.prefixHash;
+    int status;
+    if (rescan) {
+        if (fullScan != nullptr) {
+            *fullScan = true;
+        }
+        status = scanWholeFile(path, state, parser, stats);
+        state.device = (uint64_t) fileStat.st_dev;
+        state.inode = (uint64_t) fileStat.st_ino;
+    } else {
+        status = scanAppended(fd, fileSize, state, parser, stats);
+    }
+    close(fd);
+
+    getTailClassifications(state, classifications);
+    return status && state.established && state.consistentFields;
+}
+
+
+int saveTailState(const TailState &state, const string &path) {
+    const string tmpPath = path + ".tmp." + to_string(getpid());
+    {
+        ofstream os(tmpPath, ios::binary | ios::trunc);
+        if (!os.is_open()) { return 0; }
+        os.write(TAIL_STATE_MAGIC, sizeof(TAIL_STATE_MAGIC));
+        writePod(os, (int32_t) state.established);
+        writePod(os, state.device);
+        writePod(os, state.inode);
+        writePod(os, (uint64_t) state.offset);
+        writePod(os, state.prefixHash);
+        writePod(os, state.delim);
+        writePod(os, (uint64_t) state.headerLineIdx);
+        writePod(os, (int32_t) state.consistentFields);
+        writePod(os, (uint64_t) state.numRows);
+        writePod(os, (uint32_t) state.columnNames.size());
+        for (size_t columnIdx = 0; columnIdx < state.columnNames.size(); columnIdx++) {
+            writePod(os, (uint32_t) state.columnNames[columnIdx].size());
+            os.write(state.columnNames[columnIdx].data(), (streamsize) state.columnNames[columnIdx].size());
+            writePod(os, (uint8_t) state.fieldClasses[columnIdx]);
+        }
+        os.close();
+        if (!os) {
+            remove(tmpPath.c_str());
+            return 0;
+        }
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return 0;
+    }
+    return 1;
+}
+
+
+int loadTailState(const string &path, TailState &state) {
+    ifstream is(path, ios::binary);
+    if (!is.is_open()) { return 0; }
+
+    char magic[sizeof(TAIL_STATE_MAGIC)];
+    TailState loaded{};
+    int32_t established, consistentFields;
+    uint64_t offset, headerLineIdx, numRows;
+    uint32_t numColumns;
+    if (!is.read(magic, sizeof(magic)) || memcmp(magic, TAIL_STATE_MAGIC, sizeof(magic)) != 0 ||
+        !readPod(is, established) || !readPod(is, loaded.device) || !readPod(is, loaded.inode) ||
+        !readPod(is, offset) || !readPod(is, loaded.prefixHash) || !readPod(is, loaded.delim) ||
+        !readPod(is, headerLineIdx) || !readPod(is, consistentFields) || !readPod(is, numRows) ||
+        !readPod(is, numColumns)) {
+        return 0;
+    }
+    // Each column takes at least the length of its name and its classification
+    if ((uint64_t) numColumns * (sizeof(uint32_t) + sizeof(uint8_t)) > getRemainingBytes(is)) { return 0; }
+    for (uint32_t columnIdx = 0; columnIdx < numColumns; columnIdx++) {
+        uint32_t nameLen;
+        uint8_t cls;
+        if (!readPod(is, nameLen) || nameLen > getRemainingBytes(is)) { return 0; }
+        string name(nameLen, '\0');
+        if (!is.read(name.data(), nameLen) || !readPod(is, cls) || cls >= NUM_FC) { return 0; }
+        loaded.columnNames.push_back(std::move(name));
+        loaded.fieldClasses.push_back((FieldCls) cls);
+    }
+    loaded.established = established;
+    loaded.offset = offset;
+    loaded.headerLineIdx = headerLineIdx;
+    loaded.consistentFields = consistentFields;
+    loaded.numRows = numRows;
+    state = std::move(loaded);
+    return 1;
+}
@@ -0,0 +1,51 @@
+/**
+ * Definitions for the statistics that can be collected while running inference.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <inference_stats.h>
+
+using namespace std;
+
+
+InferenceStats::InferenceStats() :
+        phaseSeconds(), linesScanned(), bytesScanned(), numFieldsClassified(0), numMpcParses(0), numMpcParsesByCls(),
+        mpcParseSecondsByCls(), peakFieldStorageBytes(0) {}
+
+
+void InferenceStats::print(ostream &os) const {
+    for (int phase = 0; phase < NUM_IP; phase++) {
+        os << " - " << InferencePhaseNames[phase] << ": " << phaseSeconds[phase] * 1e3 << " ms, "
+           << linesScanned[phase] << " lines, " << bytesScanned[phase] << " bytes" << endl;
+    }
+    os << " - fields classified: " << numFieldsClassified << " (" << numMpcParses << " parsed with mpc)" << endl;
+    for (int fieldCls = 0; fieldCls < NUM_FC; fieldCls++) {
+        if (!numMpcParsesByCls[fieldCls]) { continue; }
+        os << "    - " << FieldClsCorrespondingNames[fieldCls] << ": " << numMpcParsesByCls[fieldCls] << " parses, "
+           << mpcParseSecondsByCls[fieldCls] * 1e3 << " ms" << endl;
+    }
+    os << " - peak field storage: " << peakFieldStorageBytes << " bytes" << endl;
+}
+
+
+void PipelineStats::print(ostream &os) const {
+    for (const auto &stage: stages) {
+        os << " - " << stage.name << ": " << stage.seconds * 1e3 << " ms (stalled " << stage.inputStallSeconds * 1e3
+           << " ms on input, " << stage.outputStallSeconds * 1e3 << " ms on output), " << stage.numItems << " items, "
+           << stage.numBytes << " bytes" << endl;
+    }
+}
+
+
+PhaseTimer::PhaseTimer(InferenceStats *const stats, InferencePhase phase) : _stats(stats), _phase(phase) {
+    if (_stats != nullptr) {
+        _start = chrono::steady_clock::now();
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (_stats != nullptr) {
+        _stats->phaseSeconds[_phase] += chrono::duration<double>(chrono::steady_clock::now() - _start).count();
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * Definitions for the helpers used to read a data file through a read-only memory mapping.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <mapped_file.h>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+MappedFile::MappedFile() : _data(nullptr), _size(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+int MappedFile::open(const string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return 0; }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    // mmap rejects zero-length mappings, so an empty file is represented by an empty view
+    if (fileStat.st_size == 0) {
+        ::close(fd);
+        return 1;
+    }
+
+    void *mapping = mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps its own reference to the file
+    if (mapping == MAP_FAILED) { return 0; }
+
+    // The file is read from start to end (and lines are then walked from the end), so hint sequential access
+    madvise(mapping, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+
+    _data = (const char *) mapping;
+    _size = (size_t) fileStat.st_size;
+    return 1;
+}
+
+void MappedFile::close() {
+    if (_data != nullptr) {
+        munmap((void *) _data, _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+const char *MappedFile::data() const {
+    return _data;
+}
+
+size_t MappedFile::size() const {
+    return _size;
+}
+
+string_view MappedFile::view() const {
+    return {_data, _size};
+}
+
+
+void getBufferLines(string_view buffer, vector<string_view> &ret) {
+    const char *lineStart = buffer.data();
+    const char *const bufferEnd = buffer.data() + buffer.size();
+    while (lineStart < bufferEnd) {
+        auto newline = (const char *) memchr(lineStart, '\n', bufferEnd - lineStart);
+        if (newline == nullptr) {
+            ret.emplace_back(lineStart, bufferEnd - lineStart);
+            break;
+        }
+        ret.emplace_back(lineStart, newline - lineStart);
+        lineStart = newline + 1;
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * Definitions for the thread-safe pool of parser objects.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+
+
+using namespace std;
+
+
+MpcParserPool::Lease::Lease(MpcParserPool &pool, unique_ptr<MpcParserTWrapper> parser) :
+        _pool(&pool), _parser(std::move(parser)) {}
+
+MpcParserPool::Lease::Lease(Lease &&other) noexcept: _pool(other._pool), _parser(std::move(other._parser)) {}
+
+MpcParserPool::Lease::~Lease() {
+    if (!_parser) { return; }
+    lock_guard<mutex> lock(_pool->_mutex);
+    _pool->_idleParsers.push_back(std::move(_parser));
+}
+
+MpcParserTWrapper &MpcParserPool::Lease::get() const {
+    return *_parser;
+}
+
+
+MpcParserPool::MpcParserPool() : _numCompiled(0) {}
+
+MpcParserPool::Lease MpcParserPool::acquire() {
+    {
+        lock_guard<mutex> lock(_mutex);
+        if (!_idleParsers.empty()) {
+            auto parser = std::move(_idleParsers.back());
+            _idleParsers.pop_back();
+            return {*this, std::move(parser)};
+        }
+        _numCompiled++;
+    }
+
+    // Compile outside of the lock so that other threads can return and acquire parsers in the meantime
+    return {*this, make_unique<MpcParserTWrapper>()};
+}
+
+size_t MpcParserPool::getNumCompiled() {
+    lock_guard<mutex> lock(_mutex);
+    return _numCompiled;
+}
+
+size_t MpcParserPool::getNumIdle() {
+    lock_guard<mutex> lock(_mutex);
+    return _idleParsers.size();
+}
+
+MpcParserPool &MpcParserPool::global() {
+    static MpcParserPool pool;
+    return pool;
+}
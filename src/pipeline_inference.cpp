@@ -0,0 +1,318 @@
+/**
+ * Definitions for classifying a data file with a pipeline of reader, tokenizer, and classifier threads.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+#include <spsc_queue.h>
+#include <tail_window.h>
+#include <tokenizer.h>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+
+const size_t PIPELINE_BATCH_BYTES = 65536;
+
+
+/**
+ * Block of bytes read from the file, passed from the reader to the tokenizer.
+ */
+struct ReadBlock {
+    string data;
+    int last;  // 1 for the final block (which may be empty) and 0 otherwise
+};
+
+
+/**
+ * Batch of complete data lines and the bounds of their fields, passed from the tokenizer to a classifier.
+ */
+struct TokenBatch {
+    string text;  // The lines of the batch, concatenated without their newlines
+    vector<FieldBounds> fields;  // Bounds of every field of the batch, relative to `text`
+    vector<size_t> rowEnds;  // For each line, the index in `fields` just past its last field
+    size_t numColumns;  // Number of fields of the header
+    int last;  // 1 for the final (empty) batch given to each classifier and 0 otherwise
+};
+
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * Read the file from `fd` in blocks of `blockSize` bytes with `pread` and push them to `out`.
+ */
+static void runReader(int fd, size_t fileSize, size_t blockSize, SpscQueue<ReadBlock> &out, atomic<int> &readFailed,
+                      PipelineStageStats &stageStats) {
+    const auto start = chrono::steady_clock::now();
+    size_t offset = 0;
+    do {
+        ReadBlock block{string(std::min(blockSize, fileSize - offset), '\0'), 0};
+        size_t numRead = 0;
+        while (numRead < block.data.size()) {
+            ssize_t ret = pread(fd, block.data.data() + numRead, block.data.size() - numRead,
+                                (off_t) (offset + numRead));
+            if (ret <= 0) { break; }
+            numRead += ret;
+        }
+        if (numRead < block.data.size()) {
+            readFailed = 1;
+            block.data.clear();
+        }
+        offset += block.data.size();
+        block.last = readFailed || offset == fileSize;
+        stageStats.numItems++;
+        stageStats.numBytes += block.data.size();
+        const int last = block.last;
+        out.push(std::move(block), &stageStats.outputStallSeconds);
+        if (last) { break; }
+    } while (true);
+    stageStats.seconds = secondsSince(start);
+}
+
+
+/**
+ * Splits the blocks of the file into lines, finds the header, and tokenizes the data lines after it into batches that
+ * are handed to the classifiers in turn.
+ */
+class PipelineTokenizer {
+private:
+    char _delim;
+    size_t _headerOffset;
+    vector<unique_ptr<SpscQueue<TokenBatch>>> &_outs;
+    PipelineStageStats &_stageStats;
+    string _carry;  // Start of a line that continues in the next block
+    size_t _lineOffset;  // Byte offset in the file of the next line
+    size_t _nextOut;
+    vector<FieldBounds> _bounds;
+    TokenBatch _batch;
+public:
+    int headerFound;
+    size_t headerLineIdx;  // Number of lines before the header offset, as counted by `getDelim`
+    vector<string> columnNames;
+    int consistentFields;
+
+    PipelineTokenizer(char delim, size_t headerOffset, vector<unique_ptr<SpscQueue<TokenBatch>>> &outs,
+                      PipelineStageStats &stageStats) :
+            _delim(delim), _headerOffset(headerOffset), _outs(outs), _stageStats(stageStats), _lineOffset(0),
+            _nextOut(0), _batch{"", {}, {}, 0, 0}, headerFound(0), headerLineIdx(0), consistentFields(1) {}
+
+    void pushLine(string_view line) {
+        const size_t lineOffset = _lineOffset;
+        _lineOffset += line.size() + 1;
+        if (!headerFound) {
+            if (lineOffset < _headerOffset) {
+                headerLineIdx++;
+                return;
+            }
+            if (line.empty()) { return; }
+            _bounds.clear();
+            tokenizeRecord(line.data(), line.size(), _delim, _bounds);
+            for (const auto &fieldBounds: _bounds) {
+                columnNames.emplace_back(line.substr(fieldBounds.start, fieldBounds.end - fieldBounds.start));
+            }
+            headerFound = 1;
+            return;
+        }
+        if (line.empty()) { return; }
+
+        _bounds.clear();
+        tokenizeRecord(line.data(), line.size(), _delim, _bounds);
+        if (_bounds.size() != columnNames.size()) {
+            consistentFields = 0;
+        }
+        const size_t textOffset = _batch.text.size();
+        _batch.text.append(line);
+        for (const auto &fieldBounds: _bounds) {
+            _batch.fields.push_back({textOffset + fieldBounds.start, textOffset + fieldBounds.end});
+        }
+        _batch.rowEnds.push_back(_batch.fields.size());
+        if (_batch.text.size() >= PIPELINE_BATCH_BYTES) {
+            flushBatch();
+        }
+    }
+
+    void pushBlock(string_view data, int last) {
+        size_t pos = 0;
+        if (!_carry.empty()) {
+            auto newline = (const char *) memchr(data.data(), '\n', data.size());
+            if (newline == nullptr) {
+                _carry.append(data);
+                if (last) {
+                    pushLine(_carry);
+                }
+                return;
+            }
+            pos = newline - data.data();
+            _carry.append(data.substr(0, pos));
+            pushLine(_carry);
+            _carry.clear();
+            pos++;
+        }
+        while (pos < data.size()) {
+            auto newline = (const char *) memchr(data.data() + pos, '\n', data.size() - pos);
+            if (newline == nullptr) { break; }
+            const size_t lineEnd = newline - data.data();
+            pushLine(data.substr(pos, lineEnd - pos));
+            pos = lineEnd + 1;
+        }
+        if (pos < data.size()) {
+            if (last) {
+                pushLine(data.substr(pos));
+            } else {
+                _carry.assign(data.substr(pos));
+            }
+        }
+    }
+
+    void flushBatch() {
+        if (_batch.rowEnds.empty()) { return; }
+        _batch.numColumns = columnNames.size();
+        _stageStats.numItems++;
+        _stageStats.numBytes += _batch.text.size();
+        _outs[_nextOut]->push(std::move(_batch), &_stageStats.outputStallSeconds);
+        _nextOut = (_nextOut + 1) % _outs.size();
+        _batch = {"", {}, {}, 0, 0};
+    }
+
+    /**
+     * Flush the last batch and tell every classifier that there are no more batches.
+     */
+    void finish() {
+        flushBatch();
+        for (auto &out: _outs) {
+            out->push({"", {}, {}, columnNames.size(), 1}, &_stageStats.outputStallSeconds);
+        }
+    }
+};
+
+
+static void runTokenizer(PipelineTokenizer &tokenizer, SpscQueue<ReadBlock> &in, PipelineStageStats &stageStats) {
+    const auto start = chrono::steady_clock::now();
+    ReadBlock block;
+    do {
+        in.pop(block, &stageStats.inputStallSeconds);
+        tokenizer.pushBlock(block.data, block.last);
+    } while (!block.last);
+    tokenizer.finish();
+    stageStats.seconds = secondsSince(start);
+}
+
+
+/**
+ * Fold the batches popped from `in` into a classification per column.
+ */
+static void runClassifier(SpscQueue<TokenBatch> &in, MpcParserTWrapper &parser, vector<FieldCls> &fieldClasses,
+                          PipelineStageStats &stageStats) {
+    const auto start = chrono::steady_clock::now();
+    TokenBatch batch;
+    do {
+        in.pop(batch, &stageStats.inputStallSeconds);
+        if (fieldClasses.size() < batch.numColumns) {
+            fieldClasses.resize(batch.numColumns, FC_0_LOGICAL);
+        }
+        size_t rowStart = 0;
+        for (const size_t rowEnd: batch.rowEnds) {
+            const size_t numFields = std::min(rowEnd - rowStart, batch.numColumns);
+            for (size_t fieldIdx = 0; fieldIdx < numFields; fieldIdx++) {
+                if (fieldClasses[fieldIdx] == FC_8_ARBITRY) { continue; }
+                const FieldBounds &fieldBounds = batch.fields[rowStart + fieldIdx];
+                const string_view field(batch.text.data() + fieldBounds.start, fieldBounds.end - fieldBounds.start);
+                fieldClasses[fieldIdx] = classifyFieldInColumn(field, fieldClasses[fieldIdx], parser);
+            }
+            rowStart = rowEnd;
+        }
+        if (!batch.last) {
+            stageStats.numItems++;
+            stageStats.numBytes += batch.text.size();
+        }
+    } while (!batch.last);
+    stageStats.seconds = secondsSince(start);
+}
+
+
+int classifyFilePipelined(const string &path, tuple<char, size_t> &delimRet,
+                          vector<tuple<string, FieldCls>> &classifications, size_t numClassifiers, size_t blockSize,
+                          size_t queueCapacity, PipelineStats *const stats) {
+    numClassifiers = std::max((size_t) 1, numClassifiers);
+    blockSize = std::max((size_t) 1, blockSize);
+    classifications.clear();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Could not open file " << path << endl;
+        return 0;
+    }
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    // Like `getDelim`, take the whole file as one column (with its first non-empty line as the header) if no delimiter
+    // can be inferred
+    TailDelimResult tail{};
+    if (!detectDelimFromTail(path, tail)) {
+        tail.delim = '\0';
+        tail.headerOffset = 0;
+    }
+
+    vector<PipelineStageStats> stages(2 + numClassifiers);
+    stages[0].name = "read";
+    stages[1].name = "tokenize";
+    for (size_t classifierIdx = 0; classifierIdx < numClassifiers; classifierIdx++) {
+        stages[2 + classifierIdx].name = "classify " + to_string(classifierIdx);
+    }
+
+    vector<MpcParserPool::Lease> parsers;
+    parsers.reserve(numClassifiers);
+    for (size_t classifierIdx = 0; classifierIdx < numClassifiers; classifierIdx++) {
+        parsers.push_back(MpcParserPool::global().acquire());
+    }
+
+    SpscQueue<ReadBlock> blocks(queueCapacity);
+    vector<unique_ptr<SpscQueue<TokenBatch>>> batches;
+    for (size_t classifierIdx = 0; classifierIdx < numClassifiers; classifierIdx++) {
+        batches.push_back(make_unique<SpscQueue<TokenBatch>>(queueCapacity));
+    }
+    atomic<int> readFailed(0);
+    PipelineTokenizer tokenizer(tail.delim, tail.headerOffset, batches, stages[1]);
+    vector<vector<FieldCls>> fieldClasses(numClassifiers);
+
+    vector<thread> threads;
+    threads.emplace_back(runReader, fd, (size_t) fileStat.st_size, blockSize, ref(blocks), ref(readFailed),
+                         ref(stages[0]));
+    threads.emplace_back(runTokenizer, ref(tokenizer), ref(blocks), ref(stages[1]));
+    for (size_t classifierIdx = 0; classifierIdx < numClassifiers; classifierIdx++) {
+        threads.emplace_back(runClassifier, ref(*batches[classifierIdx]), ref(parsers[classifierIdx].get()),
+                             ref(fieldClasses[classifierIdx]), ref(stages[2 + classifierIdx]));
+    }
+    for (auto &stageThread: threads) {
+        stageThread.join();
+    }
+    close(fd);
+    if (stats != nullptr) {
+        stats->stages = std::move(stages);
+    }
+
+    delimRet = {tail.delim, tokenizer.headerLineIdx};
+    if (readFailed || !tokenizer.headerFound) { return 0; }
+    for (size_t columnIdx = 0; columnIdx < tokenizer.columnNames.size(); columnIdx++) {
+        FieldCls fieldCls = FC_0_LOGICAL;
+        for (const auto &classifierClasses: fieldClasses) {
+            if (columnIdx < classifierClasses.size()) {
+                fieldCls = std::max(fieldCls, classifierClasses[columnIdx]);
+            }
+        }
+        classifications.emplace_back(tokenizer.columnNames[columnIdx], fieldCls);
+    }
+    return tokenizer.consistentFields;
+}
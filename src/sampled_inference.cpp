@@ -0,0 +1,167 @@
+/**
+ * Definitions for classifying the columns of a data file from a random sample of its rows.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+#include <tail_window.h>
+#include <tokenizer.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+
+const size_t MAX_RESYNC_LINES = 8;
+
+
+/**
+ * @return The offset just past the end of the line that starts at `lineStart` (i.e., past its newline, or the end of
+ *  the buffer).
+ */
+static size_t getLineEnd(string_view buffer, size_t lineStart) {
+    auto newline = (const char *) memchr(buffer.data() + lineStart, '\n', buffer.size() - lineStart);
+    return newline == nullptr ? buffer.size() : newline - buffer.data() + 1;
+}
+
+
+/**
+ * Accumulates the classifications of sampled rows.
+ */
+class SampleAccumulator {
+private:
+    MpcParserTWrapper &_parser;
+    ClassificationEngine _engine;
+    char _delim;
+    vector<FieldBounds> _bounds;
+    vector<array<size_t, NUM_FC>> _clsCounts;  // Number of sampled fields of each classification, per column
+public:
+    vector<SampledColumnCls> &columns;
+    size_t numSamples;
+
+    SampleAccumulator(MpcParserTWrapper &parser, ClassificationEngine engine, char delim,
+                      vector<SampledColumnCls> &columns) :
+            _parser(parser), _engine(engine), _delim(delim), _clsCounts(columns.size()), columns(columns),
+            numSamples(0) {}
+
+    /**
+     * @return 1 if the line had as many fields as there are columns (in which case it was added to the sample) and 0
+     *  if not.
+     */
+    int addLine(string_view line) {
+        if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+        _bounds.clear();
+        tokenizeRecord(line.data(), line.size(), _delim, _bounds);
+        if (_bounds.size() != columns.size()) { return 0; }
+
+        vector<FieldCls> lineClasses(columns.size());
+        for (size_t col = 0; col < columns.size(); col++) {
+            lineClasses[col] = classifyField(line.substr(_bounds[col].start, _bounds[col].end - _bounds[col].start),
+                                             _parser, _engine);
+        }
+        numSamples++;
+        for (size_t col = 0; col < columns.size(); col++) {
+            auto &column = columns[col];
+            if (lineClasses[col] > column.cls) {
+                column.cls = lineClasses[col];
+                column.numSupporting = 0;
+            }
+            column.numSupporting += lineClasses[col] == column.cls;
+            column.numSamples++;
+            _clsCounts[col][lineClasses[col]]++;
+        }
+        return 1;
+    }
+
+    /**
+     * @return The number of classifications that exactly one sampled field of the column has.
+     */
+    size_t getNumSingletonClasses(size_t col) const {
+        return count(_clsCounts[col].begin(), _clsCounts[col].end(), (size_t) 1);
+    }
+};
+
+
+int classifyFileSampled(const string &path, SampledInferenceResult &ret, MpcParserTWrapper &parser,
+                        size_t numSamples, uint64_t seed, ClassificationEngine engine) {
+    ret = {'\0', 0, 0, 0, {}};
+    numSamples = std::max((size_t) 1, numSamples);
+
+    TailDelimResult tail{};
+    if (!detectDelimFromTail(path, tail)) { return 0; }
+    ret.delim = tail.delim;
+    ret.headerOffset = tail.headerOffset;
+
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "Could not open file " << path << endl;
+        return 0;
+    }
+    const string_view buffer = file.view();
+
+    // Column names
+    const size_t dataStart = getLineEnd(buffer, ret.headerOffset);
+    string_view headerLine = buffer.substr(ret.headerOffset, dataStart - ret.headerOffset);
+    if (!headerLine.empty() && headerLine.back() == '\n') headerLine.remove_suffix(1);
+    vector<FieldBounds> headerBounds;
+    tokenizeRecord(headerLine.data(), headerLine.size(), ret.delim, headerBounds);
+    string name;
+    for (const auto &bounds: headerBounds) {
+        unescapeField(headerLine.data(), bounds, name);
+        ret.columns.push_back({name, FC_0_LOGICAL, 0, 0, 0});
+    }
+    SampleAccumulator accumulator(parser, engine, ret.delim, ret.columns);
+
+    // Sample every data line if there are few enough of them, which only requires looking at numSamples + 1 lines
+    vector<size_t> lineStarts;
+    for (size_t lineStart = dataStart; lineStart < buffer.size() && lineStarts.size() <= numSamples;
+         lineStart = getLineEnd(buffer, lineStart)) {
+        lineStarts.push_back(lineStart);
+    }
+    if (lineStarts.size() <= numSamples) {
+        ret.exhaustive = 1;
+        for (size_t lineStart: lineStarts) {
+            string_view line = buffer.substr(lineStart, getLineEnd(buffer, lineStart) - lineStart);
+            if (line.empty() || line == "\n") continue;
+            ret.numRejectedLines += !accumulator.addLine(line);
+        }
+    } else {
+        mt19937_64 rng(seed);
+        const size_t dataSize = buffer.size() - dataStart;
+        size_t prevSampleStart = string::npos;
+        for (size_t stratum = 0; stratum < numSamples; stratum++) {
+            const size_t stratumStart = dataStart + dataSize * stratum / numSamples;
+            const size_t stratumEnd = dataStart + dataSize * (stratum + 1) / numSamples;
+            if (stratumEnd == stratumStart) continue;
+            const size_t offset = uniform_int_distribution<size_t>(stratumStart, stratumEnd - 1)(rng);
+
+            // Re-sync to the start of the first line at or after the offset (the header's newline precedes dataStart)
+            size_t lineStart = getLineEnd(buffer, offset - 1);
+            for (size_t attempt = 0; attempt < MAX_RESYNC_LINES && lineStart < buffer.size(); attempt++) {
+                // Neighbouring strata can re-sync to the same line, which is only sampled once
+                if (lineStart == prevSampleStart) break;
+                const size_t lineEnd = getLineEnd(buffer, lineStart);
+                string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+                if (!line.empty() && line != "\n") {
+                    if (accumulator.addLine(line)) {
+                        prevSampleStart = lineStart;
+                        break;
+                    }
+                    ret.numRejectedLines++;
+                }
+                lineStart = lineEnd;
+            }
+        }
+    }
+
+    for (size_t col = 0; col < ret.columns.size(); col++) {
+        auto &column = ret.columns[col];
+        const auto n = (double) column.numSamples;
+        const auto numSingletons = (double) accumulator.getNumSingletonClasses(col);
+        column.confidence = ret.exhaustive ? 1.0 : std::max(0.0, 1.0 - (3.0 + numSingletons) / n);
+    }
+    return accumulator.numSamples > 0;
+}
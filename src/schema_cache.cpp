@@ -0,0 +1,176 @@
+/**
+ * Definitions for the on-disk cache of the results of inference on data files.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <schema_cache.h>
+#include <hash.h>
+#include <pod_io.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+
+const char SCHEMA_CACHE_MAGIC[8]{'T', 'D', 'I', 'S', 'C', 'H', 'M', '1'};
+
+
+/**
+ * Read exactly `len` bytes at an offset of a file.
+ *
+ * @return 1 if the bytes were read and 0 if not.
+ */
+static int preadAll(int fd, char *buf, size_t len, size_t offset) {
+    while (len > 0) {
+        ssize_t numRead = pread(fd, buf, len, (off_t) offset);
+        if (numRead <= 0) { return 0; }
+        buf += numRead;
+        len -= numRead;
+        offset += numRead;
+    }
+    return 1;
+}
+
+
+int getFileFingerprint(const string &path, FileFingerprint &ret, size_t blockSize) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return 0; }
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 0;
+    }
+    ret.size = (uint64_t) fileStat.st_size;
+    ret.mtimeNs = (int64_t) fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+
+    // The blocks overlap (or are the same) for files smaller than two blocks, which is harmless
+    const size_t numBytes = std::min(blockSize, (size_t) ret.size);
+    string block(numBytes, '\0');
+    int status = preadAll(fd, block.data(), numBytes, 0);
+    ret.blocksHash = fnv1aHash(block.data(), block.size());
+    status = status && preadAll(fd, block.data(), numBytes, ret.size - numBytes);
+    ret.blocksHash = fnv1aHash(block.data(), block.size(), ret.blocksHash);
+    close(fd);
+    return status;
+}
+
+
+SchemaCache::SchemaCache(string directory) : _directory(std::move(directory)) {}
+
+const string &SchemaCache::getDirectory() const {
+    return _directory;
+}
+
+string SchemaCache::getEntryPath(const FileFingerprint &fingerprint) const {
+    uint64_t hash = fnv1aHash((const char *) &fingerprint.size, sizeof(fingerprint.size));
+    hash = fnv1aHash((const char *) &fingerprint.mtimeNs, sizeof(fingerprint.mtimeNs), hash);
+    hash = fnv1aHash((const char *) &fingerprint.blocksHash, sizeof(fingerprint.blocksHash), hash);
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.schema", (unsigned long long) hash);
+    return (filesystem::path(_directory) / name).string();
+}
+
+
+int SchemaCache::lookup(const string &path, const FileFingerprint &fingerprint, int &status,
+                        tuple<char, size_t> &delimRet, vector<tuple<string, FieldCls>> &classifications) const {
+    ifstream entry(getEntryPath(fingerprint), ios::binary);
+    if (!entry.is_open()) { return 0; }
+
+    char magic[sizeof(SCHEMA_CACHE_MAGIC)];
+    FileFingerprint entryFingerprint{};
+    uint64_t headerOffset, headerLen, headerHash, headerLineIdx;
+    int32_t entryStatus;
+    char delim;
+    uint32_t numColumns;
+    if (!entry.read(magic, sizeof(magic)) || memcmp(magic, SCHEMA_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        !readPod(entry, entryFingerprint.size) || !readPod(entry, entryFingerprint.mtimeNs) ||
+        !readPod(entry, entryFingerprint.blocksHash) || !readPod(entry, headerOffset) || !readPod(entry, headerLen) ||
+        !readPod(entry, headerHash) || !readPod(entry, entryStatus) || !readPod(entry, delim) ||
+        !readPod(entry, headerLineIdx) || !readPod(entry, numColumns)) {
+        return 0;
+    }
+    if (entryFingerprint.size != fingerprint.size || entryFingerprint.mtimeNs != fingerprint.mtimeNs ||
+        entryFingerprint.blocksHash != fingerprint.blocksHash || headerLen > fingerprint.size ||
+        headerOffset > fingerprint.size - headerLen) {
+        return 0;
+    }
+
+    // Each column takes at least the length of its name and its classification
+    if ((uint64_t) numColumns * (sizeof(uint32_t) + sizeof(uint8_t)) > getRemainingBytes(entry)) { return 0; }
+    vector<tuple<string, FieldCls>> entryClassifications;
+    entryClassifications.reserve(numColumns);
+    for (uint32_t columnIdx = 0; columnIdx < numColumns; columnIdx++) {
+        uint32_t nameLen;
+        uint8_t cls;
+        if (!readPod(entry, nameLen) || nameLen > getRemainingBytes(entry)) { return 0; }
+        string name(nameLen, '\0');
+        if (!entry.read(name.data(), nameLen) || !readPod(entry, cls) || cls >= NUM_FC) { return 0; }
+        entryClassifications.emplace_back(std::move(name), (FieldCls) cls);
+    }
+
+    // Validate the entry against the header line of the file
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return 0; }
+    string headerLine(headerLen, '\0');
+    int headerRead = preadAll(fd, headerLine.data(), headerLen, headerOffset);
+    close(fd);
+    if (!headerRead || fnv1aHash(headerLine.data(), headerLine.size()) != headerHash) { return 0; }
+
+    status = entryStatus;
+    delimRet = {delim, (size_t) headerLineIdx};
+    classifications = std::move(entryClassifications);
+    return 1;
+}
+
+
+int SchemaCache::store(const FileFingerprint &fingerprint, size_t headerOffset, string_view headerLine, int status,
+                       const tuple<char, size_t> &delimRet,
+                       const vector<tuple<string, FieldCls>> &classifications) const {
+    error_code errorCode;
+    filesystem::create_directories(_directory, errorCode);
+    if (errorCode) { return 0; }
+
+    // The temporary file is unique to this process and thread, so concurrent stores of the same entry don't interleave
+    const string entryPath = getEntryPath(fingerprint);
+    ostringstream tmpPath;
+    tmpPath << entryPath << ".tmp." << getpid() << '.' << this_thread::get_id();
+    {
+        ofstream entry(tmpPath.str(), ios::binary | ios::trunc);
+        if (!entry.is_open()) { return 0; }
+        entry.write(SCHEMA_CACHE_MAGIC, sizeof(SCHEMA_CACHE_MAGIC));
+        writePod(entry, fingerprint.size);
+        writePod(entry, fingerprint.mtimeNs);
+        writePod(entry, fingerprint.blocksHash);
+        writePod(entry, (uint64_t) headerOffset);
+        writePod(entry, (uint64_t) headerLine.size());
+        writePod(entry, fnv1aHash(headerLine.data(), headerLine.size()));
+        writePod(entry, (int32_t) status);
+        writePod(entry, get<0>(delimRet));
+        writePod(entry, (uint64_t) get<1>(delimRet));
+        writePod(entry, (uint32_t) classifications.size());
+        for (const auto &classification: classifications) {
+            const string &name = get<0>(classification);
+            writePod(entry, (uint32_t) name.size());
+            entry.write(name.data(), (streamsize) name.size());
+            writePod(entry, (uint8_t) get<1>(classification));
+        }
+        entry.close();
+        if (!entry) {
+            remove(tmpPath.str().c_str());
+            return 0;
+        }
+    }
+    if (rename(tmpPath.str().c_str(), entryPath.c_str()) != 0) {
+        remove(tmpPath.str().c_str());
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,225 @@
+/**
+ * Definitions for classifying byte ranges of a data file separately (e.g., in several processes) and merging the
+ * results.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tabulated_data_inference.h>
+#include <pod_io.h>
+#include <tail_window.h>
+#include <tokenizer.h>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+
+
+const char PARTIAL_CLASSIFICATION_MAGIC[8]{'T', 'D', 'I', 'P', 'A', 'R', 'T', '1'};
+const size_t SERIALIZED_SKETCH_BYTES = 9 * 8 + HLL_NUM_REGISTERS;
+
+
+/**
+ * @return The offset just past the newline of the line that contains `offset` (or the end of the buffer).
+ */
+static size_t getNextLineStart(string_view buffer, size_t offset) {
+    auto newline = (const char *) memchr(buffer.data() + offset, '\n', buffer.size() - offset);
+    return newline == nullptr ? buffer.size() : newline - buffer.data() + 1;
+}
+
+
+PartialClassification::PartialClassification() :
+        numRows(0), minNumFields(numeric_limits<size_t>::max()), maxNumFields(0) {}
+
+
+void PartialClassification::merge(const PartialClassification &other) {
+    numRows += other.numRows;
+    minNumFields = std::min(minNumFields, other.minNumFields);
+    maxNumFields = std::max(maxNumFields, other.maxNumFields);
+    if (fieldClasses.size() < other.fieldClasses.size()) {
+        fieldClasses.resize(other.fieldClasses.size(), FC_0_LOGICAL);
+    }
+    for (size_t columnIdx = 0; columnIdx < other.fieldClasses.size(); columnIdx++) {
+        fieldClasses[columnIdx] = std::max(fieldClasses[columnIdx], other.fieldClasses[columnIdx]);
+    }
+    if (sketches.size() < other.sketches.size()) {
+        sketches.resize(other.sketches.size());
+    }
+    for (size_t columnIdx = 0; columnIdx < other.sketches.size(); columnIdx++) {
+        sketches[columnIdx].merge(other.sketches[columnIdx]);
+    }
+}
+
+
+int PartialClassification::isConsistent(size_t numColumns) const {
+    return numRows == 0 || (minNumFields == numColumns && maxNumFields == numColumns);
+}
+
+
+void PartialClassification::getClassifications(const vector<string> &columnNames,
+                                               vector<tuple<string, FieldCls>> &classifications) const {
+    for (size_t columnIdx = 0; columnIdx < columnNames.size(); columnIdx++) {
+        classifications.emplace_back(columnNames[columnIdx],
+                                     columnIdx < fieldClasses.size() ? fieldClasses[columnIdx] : FC_0_LOGICAL);
+    }
+}
+
+
+int getShardLayout(const string &path, ShardLayout &ret) {
+    ret = {'\0', 0, 0, 0, 0, {}};
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "Could not open file " << path << endl;
+        return 0;
+    }
+    const string_view buffer = file.view();
+    ret.fileSize = buffer.size();
+
+    // Like `getDelim`, take the whole file as one column if no delimiter can be inferred
+    TailDelimResult tail{};
+    if (detectDelimFromTail(path, tail)) {
+        ret.delim = tail.delim;
+        ret.headerOffset = tail.headerOffset;
+    }
+    for (size_t lineStart = 0; lineStart < ret.headerOffset; lineStart = getNextLineStart(buffer, lineStart)) {
+        ret.headerLineIdx++;
+    }
+
+    // The header is the first non-empty line at or after the header offset
+    size_t headerStart = ret.headerOffset;
+    while (headerStart < buffer.size() && buffer[headerStart] == '\n') {
+        headerStart++;
+    }
+    if (headerStart == buffer.size()) {
+        ret.dataOffset = buffer.size();
+        return 0;
+    }
+    ret.dataOffset = getNextLineStart(buffer, headerStart);
+    string_view header = buffer.substr(headerStart, ret.dataOffset - headerStart);
+    if (header.back() == '\n') header.remove_suffix(1);
+    vector<FieldBounds> bounds;
+    tokenizeRecord(header.data(), header.size(), ret.delim, bounds);
+    for (const auto &fieldBounds: bounds) {
+        ret.columnNames.emplace_back(header.substr(fieldBounds.start, fieldBounds.end - fieldBounds.start));
+    }
+    return 1;
+}
+
+
+int classifyByteRange(const string &path, char delim, size_t begin, size_t end, PartialClassification &ret,
+                      MpcParserTWrapper &parser, bool collectSketches) {
+    ret = PartialClassification();
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "Could not open file " << path << endl;
+        return 0;
+    }
+    const string_view buffer = file.view();
+    end = std::min(end, buffer.size());
+    if (begin >= end) { return 1; }
+
+    // A line belongs to the range that contains its first byte, so a range that starts within a line skips it
+    size_t lineStart = begin == 0 || buffer[begin - 1] == '\n' ? begin : getNextLineStart(buffer, begin);
+    vector<FieldBounds> bounds;
+    while (lineStart < end) {
+        const size_t nextLineStart = getNextLineStart(buffer, lineStart);
+        string_view line = buffer.substr(lineStart, nextLineStart - lineStart);
+        lineStart = nextLineStart;
+        if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+        if (line.empty()) { continue; }
+
+        bounds.clear();
+        tokenizeRecord(line.data(), line.size(), delim, bounds);
+        ret.numRows++;
+        ret.minNumFields = std::min(ret.minNumFields, bounds.size());
+        ret.maxNumFields = std::max(ret.maxNumFields, bounds.size());
+        if (ret.fieldClasses.size() < bounds.size()) {
+            ret.fieldClasses.resize(bounds.size(), FC_0_LOGICAL);
+            if (collectSketches) {
+                ret.sketches.resize(bounds.size());
+            }
+        }
+        for (size_t fieldIdx = 0; fieldIdx < bounds.size(); fieldIdx++) {
+            const string_view field = line.substr(bounds[fieldIdx].start,
+                                                  bounds[fieldIdx].end - bounds[fieldIdx].start);
+            if (collectSketches) {
+                ret.sketches[fieldIdx].add(field);
+            }
+            if (ret.fieldClasses[fieldIdx] == FC_8_ARBITRY) { continue; }
+            ret.fieldClasses[fieldIdx] = classifyFieldInColumn(field, ret.fieldClasses[fieldIdx], parser);
+        }
+    }
+    return 1;
+}
+
+
+void serializePartialClassification(const PartialClassification &partial, string &ret) {
+    ostringstream os(ios::binary);
+    os.write(PARTIAL_CLASSIFICATION_MAGIC, sizeof(PARTIAL_CLASSIFICATION_MAGIC));
+    writePod(os, (uint64_t) partial.numRows);
+    writePod(os, (uint64_t) partial.minNumFields);
+    writePod(os, (uint64_t) partial.maxNumFields);
+    writePod(os, (uint32_t) partial.fieldClasses.size());
+    for (const FieldCls fieldCls: partial.fieldClasses) {
+        writePod(os, (uint8_t) fieldCls);
+    }
+    writePod(os, (uint32_t) partial.sketches.size());
+    for (const auto &sketch: partial.sketches) {
+        writePod(os, (uint64_t) sketch.numFields);
+        writePod(os, (uint64_t) sketch.numEmpty);
+        writePod(os, (uint64_t) sketch.numNull);
+        writePod(os, (uint64_t) sketch.numInt64);
+        writePod(os, sketch.minInt64);
+        writePod(os, sketch.maxInt64);
+        writePod(os, (uint64_t) sketch.numDouble);
+        writePod(os, sketch.minDouble);
+        writePod(os, sketch.maxDouble);
+        os.write((const char *) sketch.hllRegisters.data(), (streamsize) sketch.hllRegisters.size());
+    }
+    ret = os.str();
+}
+
+
+int deserializePartialClassification(string_view blob, PartialClassification &ret) {
+    istringstream is(string(blob), ios::binary);
+    char magic[sizeof(PARTIAL_CLASSIFICATION_MAGIC)];
+    uint64_t numRows, minNumFields, maxNumFields;
+    uint32_t numColumns, numSketches;
+    if (!is.read(magic, sizeof(magic)) || memcmp(magic, PARTIAL_CLASSIFICATION_MAGIC, sizeof(magic)) != 0 ||
+        !readPod(is, numRows) || !readPod(is, minNumFields) || !readPod(is, maxNumFields) ||
+        !readPod(is, numColumns)) {
+        return 0;
+    }
+
+    PartialClassification loaded;
+    loaded.numRows = numRows;
+    loaded.minNumFields = minNumFields;
+    loaded.maxNumFields = maxNumFields;
+    for (uint32_t columnIdx = 0; columnIdx < numColumns; columnIdx++) {
+        uint8_t cls;
+        if (!readPod(is, cls) || cls >= NUM_FC) { return 0; }
+        loaded.fieldClasses.push_back((FieldCls) cls);
+    }
+    if (!readPod(is, numSketches) || (numSketches != 0 && numSketches != numColumns) ||
+        (uint64_t) numSketches * SERIALIZED_SKETCH_BYTES > getRemainingBytes(is)) {
+        return 0;
+    }
+    loaded.sketches.resize(numSketches);
+    for (auto &sketch: loaded.sketches) {
+        uint64_t numFields, numEmpty, numNull, numInt64, numDouble;
+        if (!readPod(is, numFields) || !readPod(is, numEmpty) || !readPod(is, numNull) || !readPod(is, numInt64) ||
+            !readPod(is, sketch.minInt64) || !readPod(is, sketch.maxInt64) || !readPod(is, numDouble) ||
+            !readPod(is, sketch.minDouble) || !readPod(is, sketch.maxDouble) ||
+            !is.read((char *) sketch.hllRegisters.data(), (streamsize) sketch.hllRegisters.size())) {
+            return 0;
+        }
+        sketch.numFields = numFields;
+        sketch.numEmpty = numEmpty;
+        sketch.numNull = numNull;
+        sketch.numInt64 = numInt64;
+        sketch.numDouble = numDouble;
+    }
+    ret = std::move(loaded);
+    return 1;
+}
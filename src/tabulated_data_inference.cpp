@@ -6,6 +6,13 @@
 
 #include <tabulated_data_inference.h>
 #include <include/delim_helpers.h>
+#include <tokenizer.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <type_traits>
 
 
 using namespace std;
@@ -13,7 +20,7 @@ using namespace std;
 
 MpcParserTWrapper::MpcParserTWrapper() {
     mpc_parser_t* parser;
-    mpc_setup(&parser, _allParsers);
+    mpc_setup(&parser, _allParsers, _groupParsers);
     _parser = parser;
 }
 
@@ -21,6 +28,10 @@ mpc_parser_t *MpcParserTWrapper::getParserPtr() const {
     return _parser;
 }
 
+mpc_parser_t *MpcParserTWrapper::getGroupParserPtr(GrammarGroup group) const {
+    return _groupParsers[group];
+}
+
 MpcParserTWrapper::~MpcParserTWrapper() {
     for (auto pIterator = _allParsers.rbegin(); pIterator != _allParsers.rend(); pIterator++) {
         mpc_undefine(*pIterator);
@@ -31,7 +42,24 @@ MpcParserTWrapper::~MpcParserTWrapper() {
 }
 
 
-tuple<char, size_t> getDelim(const vector<string> &lines) {
+/**
+ * Add the lines from `firstLineIdx` to the end of `lines` (which inference scans in reverse) to the lines and bytes
+ * scanned by a phase.
+ */
+template<typename LineT>
+static void addScannedLines(const vector<LineT> &lines, size_t firstLineIdx, InferenceStats *const stats,
+                            InferencePhase phase) {
+    if (stats == nullptr) { return; }
+    stats->linesScanned[phase] += lines.size() - firstLineIdx;
+    for (size_t lineIdx = firstLineIdx; lineIdx < lines.size(); lineIdx++) {
+        stats->bytesScanned[phase] += lines[lineIdx].size();
+    }
+}
+
+
+template<typename LineT>
+static tuple<char, size_t> getDelimImpl(const vector<LineT> &lines, InferenceStats *const stats) {
+    PhaseTimer timer(stats, IP_DELIM);
 #ifdef PRINT_FILE_CONTENTS
     for (const auto& line : lines) {
         cout << line << endl;
@@ -41,7 +69,7 @@ tuple<char, size_t> getDelim(const vector<string> &lines) {
 
     size_t consistencyCount[NDELIMS] = {0};
     size_t prevDelimCount[NDELIMS] = {0};
-    size_t delimCount[NDELIMS + 1] = {0};  // Last element is throwaway
+    size_t delimCount[NDELIMS] = {0};
 
     size_t revLineIdx = lines.size();
     size_t lastNonemptyRevLineIdx = revLineIdx;
@@ -57,9 +85,7 @@ tuple<char, size_t> getDelim(const vector<string> &lines) {
             delimCount[i] = 0;
         }
 
-        for (auto charInLine: *revLineIterator) {
-            delimCount[get_delim_idx(charInLine)] += 1;
-        }
+        countDelims(revLineIterator->data(), revLineIterator->size(), delimCount);
 
         state = delimFinderStateTrans(state, delimCount, prevDelimCount, consistencyCount);
         if (state == DFS_FSM_NO_CONSISTENCIES_LEFT) {
@@ -68,6 +94,7 @@ tuple<char, size_t> getDelim(const vector<string> &lines) {
 
         lastNonemptyRevLineIdx = revLineIdx;
     }
+    addScannedLines(lines, revLineIdx, stats, IP_DELIM);
 
     // Either no consistencies are left or all lines have been iterated through; return the delimiter with the highest
     // consistency if at least one consistency > 0. Return null if there is a tie, if no consistencies were found, or
@@ -94,45 +121,154 @@ tuple<char, size_t> getDelim(const vector<string> &lines) {
 }
 
 
-int getFields(const vector<string> &lines, char delim, vector<vector<string>> &ret, size_t stopAt) {
+tuple<char, size_t> getDelim(const vector<string> &lines, InferenceStats *const stats) {
+    return getDelimImpl(lines, stats);
+}
+
+
+tuple<char, size_t> getDelim(const vector<string_view> &lines, InferenceStats *const stats) {
+    return getDelimImpl(lines, stats);
+}
+
+
+static void splitLine(const string &line, char delim, vector<FieldBounds> &bounds, vector<string> &ret) {
+    tokenizeRecord(line.data(), line.size(), delim, bounds);
+    ret.resize(bounds.size());
+    for (size_t i = 0; i < bounds.size(); i++) {
+        unescapeField(line.data(), bounds[i], ret[i]);
+    }
+}
+
+
+static void splitLine(string_view line, char delim, vector<FieldBounds> &bounds, vector<string_view> &ret) {
+    // Views can't be unescaped in place, so escaped quotes are left in quoted fields
+    tokenizeRecord(line.data(), line.size(), delim, bounds);
+    ret.reserve(bounds.size());
+    for (const auto &fieldBounds: bounds) {
+        ret.push_back(line.substr(fieldBounds.start, fieldBounds.end - fieldBounds.start));
+    }
+}
+
+
+/**
+ * @return The number of bytes of heap memory used to hold rows of fields (including the contents of strings that don't
+ *  fit in the string object itself).
+ */
+template<typename FieldT>
+static size_t getFieldStorageBytes(const vector<vector<FieldT>> &rows) {
+    size_t numBytes = rows.capacity() * sizeof(vector<FieldT>);
+    for (const auto &row: rows) {
+        numBytes += row.capacity() * sizeof(FieldT);
+        if constexpr (is_same_v<FieldT, string>) {
+            for (const auto &field: row) {
+                const auto *fieldObject = (const char *) &field;
+                const bool isInline = field.data() >= fieldObject && field.data() < fieldObject + sizeof(field);
+                numBytes += isInline ? 0 : field.capacity() + 1;
+            }
+        }
+    }
+    return numBytes;
+}
+
+
+/**
+ * @return The index of the first line that `getFields` reads given `stopAt` (i.e., the index at which reverse iteration
+ *  stops).
+ */
+template<typename LineT>
+static size_t getFieldsFirstLineIdx(const vector<LineT> &lines, size_t stopAt) {
+    return stopAt < lines.size() && !lines[stopAt].empty() ? stopAt : 0;
+}
+
+
+template<typename LineT>
+static int getFieldsImpl(const vector<LineT> &lines, char delim, vector<vector<LineT>> &ret, size_t stopAt,
+                         InferenceStats *const stats) {
+    PhaseTimer timer(stats, IP_FIELDS);
     if (lines.empty()) { return -1; }
 
     size_t numFieldsEncountered = 0;
     int consistentNumFields = -1;
     size_t lineIdx = lines.size();
+    vector<FieldBounds> bounds;
     for (auto revLineIterator = lines.rbegin(); revLineIterator != lines.rend(); revLineIterator++) {
         lineIdx--;
         if (revLineIterator->empty()) {
             continue;
         }
 
-        vector<string> splitLine;
-        boost::split(splitLine, *revLineIterator, boost::is_any_of(string{delim}));
+        vector<LineT> lineFields;
+        bounds.clear();
+        splitLine(*revLineIterator, delim, bounds, lineFields);
 
         if (consistentNumFields == -1) {
-            numFieldsEncountered = splitLine.size();
+            numFieldsEncountered = lineFields.size();
             consistentNumFields = 1;
         } else {
-            if (numFieldsEncountered != splitLine.size()) {
+            if (numFieldsEncountered != lineFields.size()) {
                 consistentNumFields &= 0;
             }
         }
 
-        ret.push_back(splitLine);
+        ret.push_back(std::move(lineFields));
 
         if (lineIdx == stopAt) { break; }
     }
     reverse(ret.begin(), ret.end());
+
+    if (stats != nullptr) {
+        addScannedLines(lines, getFieldsFirstLineIdx(lines, stopAt), stats, IP_FIELDS);
+        stats->peakFieldStorageBytes = std::max(stats->peakFieldStorageBytes, getFieldStorageBytes(ret));
+    }
+    return consistentNumFields;
+}
+
+
+int getFields(const vector<string> &lines, char delim, vector<vector<string>> &ret, size_t stopAt,
+              InferenceStats *const stats) {
+    return getFieldsImpl(lines, delim, ret, stopAt, stats);
+}
+
+
+int getFields(const vector<string_view> &lines, char delim, vector<vector<string_view>> &ret, size_t stopAt,
+              InferenceStats *const stats) {
+    return getFieldsImpl(lines, delim, ret, stopAt, stats);
+}
+
+
+template<typename LineT>
+static int getColumnarFieldsImpl(const vector<LineT> &lines, char delim, ColumnarFields &ret, size_t stopAt,
+                                 InferenceStats *const stats) {
+    PhaseTimer timer(stats, IP_FIELDS);
+    int consistentNumFields = ret.assign(lines, delim, stopAt);
+    if (stats != nullptr) {
+        addScannedLines(lines, getFieldsFirstLineIdx(lines, stopAt), stats, IP_FIELDS);
+        stats->peakFieldStorageBytes = std::max(stats->peakFieldStorageBytes, ret.getStorageBytes());
+    }
     return consistentNumFields;
 }
 
 
+int getFields(const vector<string> &lines, char delim, ColumnarFields &ret, size_t stopAt,
+              InferenceStats *const stats) {
+    return getColumnarFieldsImpl(lines, delim, ret, stopAt, stats);
+}
+
+
+int getFields(const vector<string_view> &lines, char delim, ColumnarFields &ret, size_t stopAt,
+              InferenceStats *const stats) {
+    return getColumnarFieldsImpl(lines, delim, ret, stopAt, stats);
+}
+
+
 FieldCls extractFieldClsFromParser(const mpc_result_t *const mpcResult, int mpcResultRet) {
     if (mpcResultRet) {
-        string result = mpc_strip_tag(((mpc_ast_t *) mpcResult->output)->children[1]->tag);
-        const char *resultCStr = result.c_str();
+        // Compare the rule name at the start of the tag in place instead of copying it out with `mpc_strip_tag`
+        const char *tag = ((mpc_ast_t *) mpcResult->output)->children[1]->tag;
+        const size_t ruleNameLen = strcspn(tag, "|");
         for (int i = 0; i < NUM_FC - 1; i++) {
-            if (!strcmp(resultCStr, FieldClsCorrespondingNames[i])) {
+            if (!strncmp(tag, FieldClsCorrespondingNames[i], ruleNameLen) &&
+                FieldClsCorrespondingNames[i][ruleNameLen] == '\0') {
                 return (FieldCls) i;
             }
         }
@@ -144,48 +280,350 @@ FieldCls extractFieldClsFromParser(const mpc_result_t *const mpcResult, int mpcR
 void classifyColumnsAutoSetup(const vector<vector<string>> &rows, vector<tuple<string, FieldCls>> &classifications) {
     if (rows.empty()) { return; }
 
-    auto parser = MpcParserTWrapper();
-    classifyColumns(rows, classifications, parser);
+    auto lease = MpcParserPool::global().acquire();
+    classifyColumns(rows, classifications, lease.get());
 }
 
 
-void classifyColumns(const vector<vector<string>> &rows, vector<tuple<string, FieldCls>> &classifications,
-                     MpcParserTWrapper &parser) {
+/**
+ * Parse a field with one of the mpc parsers and add the parse to the statistics.
+ *
+ * @return The classification of the field, or `FC_8_ARBITRY` if the parser did not match it.
+ */
+static FieldCls parseField(string_view field, mpc_parser_t *const parser, InferenceStats *const stats) {
+    chrono::steady_clock::time_point parseStart;
+    if (stats != nullptr) {
+        parseStart = chrono::steady_clock::now();
+    }
+
+    // Fields may be views into a mapped buffer that are not null-terminated, so the length is given explicitly
     mpc_result_t parseResult;
-    int parseResultInt;
-    size_t numLines = rows.size();
-    size_t numFields = rows.at(0).size();
-    size_t lineIdx = -1;
-    size_t fieldIdx;
-
-    // Start out by classifying all fields as arbitrary strings
-    FieldCls fieldClasses[numFields];
-    for (int i = 0; i < numFields; i++) {
-        // Casting gets rid of const qualifiers
-        fieldClasses[i] = FC_0_LOGICAL;
-    }
-
-    for (auto row = rows.rbegin(); row != rows.rend(); row++) {
-        lineIdx++;
-
-        // If at the top row, extract the header and populate classifications with it and the results of the data type
-        // arbitration
-        if (lineIdx == numLines - 1) {
-            fieldIdx = -1;
-            for (const auto &field: *row) {
-                fieldIdx++;
-                classifications.emplace_back(field, fieldClasses[fieldIdx]);
+    int parseResultInt = mpc_nparse("input", field.data(), field.size(), parser, &parseResult);
+    FieldCls ret = extractFieldClsFromParser(&parseResult, parseResultInt);
+    if (parseResultInt) {
+        mpc_ast_delete((mpc_ast_t *) parseResult.output);
+    } else {
+        mpc_err_delete(parseResult.error);
+    }
+    if (stats != nullptr) {
+        stats->numMpcParses++;
+        stats->numMpcParsesByCls[ret]++;
+        stats->mpcParseSecondsByCls[ret] += chrono::duration<double>(chrono::steady_clock::now() - parseStart).count();
+    }
+    return ret;
+}
+
+
+FieldCls classifyField(string_view field, MpcParserTWrapper &parser, ClassificationEngine engine,
+                       FieldClsCache *const cache, InferenceStats *const stats) {
+    if (stats != nullptr) {
+        stats->numFieldsClassified++;
+    }
+
+    if (engine == CE_DFA) {
+        return GrammarDfa::get().classify(field.data(), field.size());
+    }
+
+    // Most fields are numeric, so only fall back to the grammar for strings that the fast path can't classify (e.g.,
+    // strings that might be dates or times)
+    FieldCls fastRet;
+    if (fastClassifyField(field.data(), field.size(), &fastRet)) {
+        return fastRet;
+    }
+
+    FieldCls cachedRet;
+    if (cache != nullptr && cache->lookup(field, &cachedRet)) {
+        return cachedRet;
+    }
+
+    FieldCls ret = parseField(field, parser.getParserPtr(), stats);
+    if (cache != nullptr) {
+        cache->insert(field, ret);
+    }
+    return ret;
+}
+
+
+FieldCls classifyFieldInColumn(string_view field, FieldCls columnCls, MpcParserTWrapper &parser,
+                               ClassificationEngine engine, FieldClsCache *const cache, InferenceStats *const stats) {
+    if (columnCls == FC_8_ARBITRY) { return FC_8_ARBITRY; }
+    if (engine == CE_DFA || columnCls == FC_0_LOGICAL) {
+        // Parsing with the group of logical values first is what `all` does already
+        return std::max(columnCls, classifyField(field, parser, engine, cache, stats));
+    }
+
+    if (stats != nullptr) {
+        stats->numFieldsClassified++;
+    }
+
+    FieldCls knownRet;
+    if (fastClassifyField(field.data(), field.size(), &knownRet) ||
+        (cache != nullptr && cache->lookup(field, &knownRet))) {
+        return std::max(columnCls, knownRet);
+    }
+
+    // A field's classification is given by the first group that it fits, so the column keeps its classification if
+    // the field fits an earlier group or fits its group with a classification no less restrictive than the column's
+    const GrammarGroup columnGroup = FieldClsGrammarGroups[columnCls];
+    const FieldCls groupRet = parseField(field, parser.getGroupParserPtr(columnGroup), stats);
+    if (groupRet <= columnCls) {
+        return columnCls;
+    }
+
+    FieldCls fieldRet = FC_8_ARBITRY;
+    for (int group = 0; group < NUM_GG && fieldRet == FC_8_ARBITRY; group++) {
+        if (group == columnGroup) {
+            fieldRet = groupRet;
+        } else {
+            fieldRet = parseField(field, parser.getGroupParserPtr((GrammarGroup) group), stats);
+        }
+    }
+    if (cache != nullptr) {
+        cache->insert(field, fieldRet);
+    }
+    return std::max(columnCls, fieldRet);
+}
+
+
+template<typename FieldT>
+static void classifyColumnsImpl(const vector<vector<FieldT>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                                MpcParserTWrapper &parser, size_t *numSkippedParses, ClassificationEngine engine,
+                                size_t cacheSize, CacheKeyType cacheKeyType, InferenceStats *const stats,
+                                vector<ColumnSketch> *const sketches) {
+    PhaseTimer timer(stats, IP_CLASSIFY);
+
+    // The first row is the header; every other row is folded into the per-column classification
+    ColumnClassifier classifier(rows.at(0), parser, engine);
+    classifier.setStats(stats);
+    if (cacheSize) {
+        classifier.enableCache(cacheSize, cacheKeyType);
+    }
+    if (sketches != nullptr) {
+        classifier.enableSketches();
+    }
+    auto row = rows.begin() + 1;
+    for (; row != rows.end() && (sketches != nullptr || !classifier.isSaturated()); row++) {
+        classifier.pushRow(*row);
+    }
+    classifier.getClassifications(classifications);
+    if (sketches != nullptr) {
+        *sketches = classifier.getSketches();
+    }
+
+    if (numSkippedParses == nullptr) { return; }
+
+    // Every field of the rows that were not read once all columns were saturated also counts as a skipped parse
+    *numSkippedParses = classifier.getNumSkippedParses();
+    for (; row != rows.end(); row++) {
+        *numSkippedParses += std::min(row->size(), classifier.getNumColumns());
+    }
+}
+
+
+void classifyColumns(const vector<vector<string>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                     MpcParserTWrapper &parser, size_t *numSkippedParses, ClassificationEngine engine,
+                     size_t cacheSize, CacheKeyType cacheKeyType, InferenceStats *const stats,
+                     vector<ColumnSketch> *const sketches) {
+    classifyColumnsImpl(rows, classifications, parser, numSkippedParses, engine, cacheSize, cacheKeyType, stats,
+                        sketches);
+}
+
+
+void classifyColumns(const vector<vector<string_view>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                     MpcParserTWrapper &parser, size_t *numSkippedParses, ClassificationEngine engine,
+                     size_t cacheSize, CacheKeyType cacheKeyType, InferenceStats *const stats,
+                     vector<ColumnSketch> *const sketches) {
+    classifyColumnsImpl(rows, classifications, parser, numSkippedParses, engine, cacheSize, cacheKeyType, stats,
+                        sketches);
+}
+
+
+void classifyColumns(const ColumnarFields &fields, vector<tuple<string, FieldCls>> &classifications,
+                     MpcParserTWrapper &parser, size_t *numSkippedParses, ClassificationEngine engine,
+                     size_t cacheSize, CacheKeyType cacheKeyType, InferenceStats *const stats,
+                     vector<ColumnSketch> *const sketches) {
+    PhaseTimer timer(stats, IP_CLASSIFY);
+    size_t numSkipped = 0;
+    FieldClsCache cache(cacheSize, cacheKeyType);
+    if (sketches != nullptr) {
+        sketches->assign(fields.getNumColumns(), ColumnSketch());
+    }
+    for (size_t columnIdx = 0; columnIdx < fields.getNumColumns(); columnIdx++) {
+        FieldCls fieldCls = FC_0_LOGICAL;
+        cache.clear();
+        for (size_t rowIdx = 1; rowIdx < fields.getNumRows(); rowIdx++) {
+            if (columnIdx >= fields.getNumFields(rowIdx)) {
+                continue;
             }
-            break;
+            if (sketches != nullptr) {
+                (*sketches)[columnIdx].add(fields.getField(rowIdx, columnIdx));
+            }
+            // Once the column is saturated its remaining fields are counted as skipped parses
+            if (fieldCls == FC_8_ARBITRY) {
+                numSkipped++;
+                continue;
+            }
+            fieldCls = classifyFieldInColumn(fields.getField(rowIdx, columnIdx), fieldCls, parser, engine,
+                                             cacheSize ? &cache : nullptr, stats);
         }
+        classifications.emplace_back(string(fields.getField(0, columnIdx)), fieldCls);
+    }
+
+    if (numSkippedParses != nullptr) {
+        *numSkippedParses = numSkipped;
+    }
+}
+
 
-        // Iterate though the fields in this row and, for each one, find the most restrictive format that fits it
-        fieldIdx = -1;
-        for (auto const &field: *row) {
-            fieldIdx++;
-            parseResultInt = mpc_parse("input", field.c_str(), parser.getParserPtr(), &parseResult);
-            auto resultEnum = extractFieldClsFromParser(&parseResult, parseResultInt);
-            fieldClasses[fieldIdx] = std::max(fieldClasses[fieldIdx], resultEnum);
+template<typename FieldT>
+static void classifyColumnsParallelImpl(const vector<vector<FieldT>> &rows,
+                                        vector<tuple<string, FieldCls>> &classifications, size_t numThreads,
+                                        ClassificationEngine engine) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, thread::hardware_concurrency());
+    }
+
+    // Without rows of data, every column keeps the most restrictive classification (as with `classifyColumns`)
+    if (rows.size() < 2) {
+        if (!rows.empty()) {
+            for (const auto &columnName: rows[0]) {
+                classifications.emplace_back(string(columnName), FC_0_LOGICAL);
+            }
         }
+        return;
     }
+
+    // Use several chunks per thread so that threads which finish early can take over the remaining work
+    const size_t numDataRows = rows.size() - 1;
+    const size_t chunkSize = std::max((size_t) 256, numDataRows / (numThreads * 8) + 1);
+    const size_t numChunks = (numDataRows + chunkSize - 1) / chunkSize;
+    numThreads = std::max((size_t) 1, std::min(numThreads, numChunks));
+
+    atomic<size_t> nextChunk(0);
+    atomic<bool> saturated(false);
+    vector<vector<FieldCls>> workerFieldClasses(numThreads);
+
+    auto worker = [&](size_t workerIdx) {
+        auto lease = MpcParserPool::global().acquire();
+        ColumnClassifier classifier(rows.at(0), lease.get(), engine);
+        for (size_t chunk = nextChunk++; chunk < numChunks && !saturated; chunk = nextChunk++) {
+            auto chunkEnd = rows.begin() + 1 + std::min((chunk + 1) * chunkSize, numDataRows);
+            for (auto row = rows.begin() + 1 + chunk * chunkSize; row != chunkEnd; row++) {
+                classifier.pushRow(*row);
+            }
+
+            // A column saturated by any worker is saturated overall, so once a worker has saturated every column none
+            // of the workers need to continue
+            if (classifier.isSaturated()) {
+                saturated = true;
+            }
+        }
+        workerFieldClasses[workerIdx] = classifier.getFieldClasses();
+    };
+
+    vector<thread> workers;
+    for (size_t workerIdx = 1; workerIdx < numThreads; workerIdx++) {
+        workers.emplace_back(worker, workerIdx);
+    }
+    worker(0);
+    for (auto &workerThread: workers) {
+        workerThread.join();
+    }
+
+    // Reduce the per-worker results by taking the least restrictive classification of each column
+    const auto &header = rows.at(0);
+    for (size_t fieldIdx = 0; fieldIdx < header.size(); fieldIdx++) {
+        FieldCls fieldCls = FC_0_LOGICAL;
+        for (const auto &fieldClasses: workerFieldClasses) {
+            fieldCls = std::max(fieldCls, fieldClasses[fieldIdx]);
+        }
+        classifications.emplace_back(string(header[fieldIdx]), fieldCls);
+    }
+}
+
+
+void classifyColumnsParallel(const vector<vector<string>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                             size_t numThreads, ClassificationEngine engine) {
+    classifyColumnsParallelImpl(rows, classifications, numThreads, engine);
+}
+
+
+void classifyColumnsParallel(const vector<vector<string_view>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                             size_t numThreads, ClassificationEngine engine) {
+    classifyColumnsParallelImpl(rows, classifications, numThreads, engine);
+}
+
+int mapFileLines(const string &path, MappedFile &file, vector<string_view> &lines, InferenceStats *const stats) {
+    PhaseTimer timer(stats, IP_READ);
+    if (!file.open(path)) {
+        cerr << "Could not open file " << path << endl;
+        return 0;
+    }
+    getBufferLines(file.view(), lines);
+    addScannedLines(lines, 0, stats, IP_READ);
+    return 1;
+}
+
+
+int classifyLines(const vector<string_view> &lines, tuple<char, size_t> &delimRet,
+                  vector<tuple<string, FieldCls>> &classifications, MpcParserTWrapper &parser, size_t *const numRows,
+                  InferenceStats *const stats) {
+    delimRet = getDelim(lines, stats);
+
+    vector<vector<string_view>> rows;
+    int consistentFields = getFields(lines, get<0>(delimRet), rows, get<1>(delimRet), stats);
+    if (numRows != nullptr) {
+        *numRows = rows.size();
+    }
+    if (rows.empty()) { return 0; }
+
+    classifyColumns(rows, classifications, parser, nullptr, CE_MPC, 0, CK_VALUE, stats);
+    return consistentFields == 1;
+}
+
+
+/**
+ * Classify a file as `classifyFile` does and, if a cache is given, store the results in it.
+ */
+static int classifyFileImpl(const string &path, tuple<char, size_t> &delimRet,
+                            vector<tuple<string, FieldCls>> &classifications, MpcParserTWrapper &parser,
+                            InferenceStats *const stats, const SchemaCache *const cache,
+                            const FileFingerprint *const fingerprint) {
+    MappedFile file;
+    vector<string_view> lines;
+    if (!mapFileLines(path, file, lines, stats)) { return 0; }
+
+    size_t numRows;
+    const int status = classifyLines(lines, delimRet, classifications, parser, &numRows, stats);
+    if (numRows == 0) { return 0; }
+    if (cache != nullptr) {
+        const string_view headerLine = lines[get<1>(delimRet)];
+        const size_t headerOffset = headerLine.empty() ? 0 : headerLine.data() - file.data();
+        cache->store(*fingerprint, headerOffset, headerLine, status, delimRet, classifications);
+    }
+    return status;
+}
+
+
+int classifyFile(const string &path, tuple<char, size_t> &delimRet, vector<tuple<string, FieldCls>> &classifications,
+                 MpcParserTWrapper &parser, InferenceStats *const stats) {
+    return classifyFileImpl(path, delimRet, classifications, parser, stats, nullptr, nullptr);
+}
+
+
+int classifyFileCached(const string &path, tuple<char, size_t> &delimRet,
+                       vector<tuple<string, FieldCls>> &classifications, MpcParserTWrapper &parser,
+                       const SchemaCache &cache, bool *const cacheHit, InferenceStats *const stats) {
+    FileFingerprint fingerprint{};
+    int status;
+    const bool hasFingerprint = getFileFingerprint(path, fingerprint);
+    const bool hit = hasFingerprint && cache.lookup(path, fingerprint, status, delimRet, classifications);
+    if (cacheHit != nullptr) {
+        *cacheHit = hit;
+    }
+    if (hit) { return status; }
+
+    // Files that can't be fingerprinted can't be read either, so classifyFile reports the error
+    return classifyFileImpl(path, delimRet, classifications, parser, stats, hasFingerprint ? &cache : nullptr,
+                            &fingerprint);
 }
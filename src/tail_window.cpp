@@ -0,0 +1,241 @@
+/**
+ * Definitions for detecting the delimiter and header of a data file from a bounded window at the end of the file.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tail_window.h>
+#include <delim_helpers.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+/**
+ * Reads the lines of a file from its end to its start, one block at a time. Lines are split in the same way as
+ * `getBufferLines`.
+ */
+class BackwardLineReader {
+private:
+    int _fd;
+    size_t _blockSize;
+    size_t _bufOffset;  // Offset in the file of the start of `_buf`
+    string _buf;
+    size_t _pos;  // End of the part of `_buf` whose lines have not been returned yet
+    bool _done;
+public:
+    size_t bytesRead;
+
+    BackwardLineReader(int fd, size_t fileSize, size_t blockSize) :
+            _fd(fd), _blockSize(blockSize), _bufOffset(fileSize), _pos(0), _done(fileSize == 0), bytesRead(0) {
+        // A newline at the end of the file does not start another (empty) line
+        if (fileSize > 0 && readBlock() && _buf[_pos - 1] == '\n') {
+            _pos--;
+        }
+    }
+
+    int readBlock() {
+        const size_t numBytes = std::min(_blockSize, _bufOffset);
+        string block(numBytes, '\0');
+        if (pread(_fd, block.data(), numBytes, (off_t) (_bufOffset - numBytes)) != (ssize_t) numBytes) {
+            _done = true;
+            return 0;
+        }
+        _bufOffset -= numBytes;
+        bytesRead += numBytes;
+        _buf = block + _buf.substr(0, _pos);
+        _pos = _buf.size();
+        return 1;
+    }
+
+    /**
+     * @param line Set to the previous line, which is valid until the next call
+     * @param lineOffset Set to the offset of the line in the file
+     * @return 1 if there was a previous line and 0 if not (or if the file could not be read).
+     */
+    int prevLine(string_view &line, size_t &lineOffset) {
+        while (!_done) {
+            size_t newlinePos = _pos == 0 ? string::npos : _buf.rfind('\n', _pos - 1);
+            if (newlinePos != string::npos) {
+                line = string_view(_buf).substr(newlinePos + 1, _pos - newlinePos - 1);
+                lineOffset = _bufOffset + newlinePos + 1;
+                _pos = newlinePos;
+                return 1;
+            }
+            if (_bufOffset == 0) {
+                line = string_view(_buf).substr(0, _pos);
+                lineOffset = 0;
+                _done = true;
+                return 1;
+            }
+            readBlock();
+        }
+        return 0;
+    }
+};
+
+
+/**
+ * Reads the lines of a file from its start to its end, one block at a time.
+ */
+class ForwardLineReader {
+private:
+    int _fd;
+    size_t _blockSize;
+    size_t _fileSize;
+    size_t _bufOffset;  // Offset in the file of the start of `_buf`
+    string _buf;
+    size_t _pos;  // Start of the part of `_buf` whose lines have not been returned yet
+public:
+    size_t bytesRead;
+
+    ForwardLineReader(int fd, size_t fileSize, size_t blockSize) :
+            _fd(fd), _blockSize(blockSize), _fileSize(fileSize), _bufOffset(0), _pos(0), bytesRead(0) {}
+
+    int nextLine(string_view &line, size_t &lineOffset) {
+        while (true) {
+            size_t newlinePos = _buf.find('\n', _pos);
+            const size_t readOffset = _bufOffset + _buf.size();
+            if (newlinePos != string::npos || (readOffset == _fileSize && _pos < _buf.size())) {
+                if (newlinePos == string::npos) newlinePos = _buf.size();
+                line = string_view(_buf).substr(_pos, newlinePos - _pos);
+                lineOffset = _bufOffset + _pos;
+                _pos = newlinePos + 1;
+                return 1;
+            }
+            if (readOffset == _fileSize) { return 0; }
+
+            const size_t numBytes = std::min(_blockSize, _fileSize - readOffset);
+            string block(numBytes, '\0');
+            if (pread(_fd, block.data(), numBytes, (off_t) readOffset) != (ssize_t) numBytes) { return 0; }
+            bytesRead += numBytes;
+            _bufOffset += std::min(_pos, _buf.size());
+            _buf = _buf.substr(std::min(_pos, _buf.size())) + block;
+            _pos = 0;
+        }
+    }
+};
+
+
+/**
+ * Find the first run of `runLength` consecutive non-empty lines (or of non-empty lines up to `stopOffset`) that each
+ * contain `delimCount` occurrences of the delimiter.
+ *
+ * @return 1 if such a run was found (and `runOffset` set to the offset of its first line) and 0 if not.
+ */
+static int findConsistentRun(ForwardLineReader &reader, int delimIdx, size_t delimCount, size_t runLength,
+                             size_t stopOffset, size_t &runOffset) {
+    string_view line;
+    size_t lineOffset;
+    size_t numConsistent = 0;
+    while (reader.nextLine(line, lineOffset)) {
+        if (lineOffset >= stopOffset) {
+            return numConsistent > 0;
+        }
+        if (line.empty()) {
+            continue;
+        }
+        size_t counts[NDELIMS] = {0};
+        countDelims(line.data(), line.size(), counts);
+        if (counts[delimIdx] != delimCount) {
+            numConsistent = 0;
+            continue;
+        }
+        if (numConsistent++ == 0) {
+            runOffset = lineOffset;
+        }
+        if (numConsistent == runLength) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+int detectDelimFromTail(const string &path, TailDelimResult &ret, size_t maxSampleLines, size_t blockSize) {
+    ret = {'\0', 0, 0, 0, 0};
+    maxSampleLines = std::max((size_t) 1, maxSampleLines);
+    blockSize = std::max((size_t) 1, blockSize);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return 0; }
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return 0;
+    }
+    const auto fileSize = (size_t) fileStat.st_size;
+
+    // Same state machine as `getDelim`, fed one line at a time from the end of the file
+    BackwardLineReader backwardReader(fd, fileSize, blockSize);
+    DelimFindingState state = DFS_FSM_NO_ENCOUNTERS;
+    size_t consistencyCount[NDELIMS] = {0};
+    size_t prevDelimCount[NDELIMS] = {0};
+    size_t delimCount[NDELIMS] = {0};
+    size_t lastConsistentOffset = fileSize;
+    size_t earliestSampledOffset = fileSize;
+    bool sampleLimitReached = false;
+
+    string_view line;
+    size_t lineOffset;
+    while (backwardReader.prevLine(line, lineOffset)) {
+        if (line.empty()) {
+            continue;
+        }
+        if (ret.numLinesSampled == maxSampleLines) {
+            sampleLimitReached = true;
+            break;
+        }
+        ret.numLinesSampled++;
+        earliestSampledOffset = lineOffset;
+
+        for (size_t i = 0; i < NDELIMS; i++) {
+            prevDelimCount[i] = delimCount[i];
+            delimCount[i] = 0;
+        }
+        countDelims(line.data(), line.size(), delimCount);
+
+        state = delimFinderStateTrans(state, delimCount, prevDelimCount, consistencyCount);
+        if (state == DFS_FSM_NO_CONSISTENCIES_LEFT) {
+            break;
+        }
+        lastConsistentOffset = lineOffset;
+    }
+    ret.bytesRead = backwardReader.bytesRead;
+
+    // Choose the delimiter in the same way as `getDelim` (no ties)
+    size_t maxConsistency = 0;
+    size_t maxConsistencyIdx = 0;
+    for (size_t i = 0; i < NDELIMS; i++) {
+        if (consistencyCount[i] > maxConsistency) {
+            maxConsistency = consistencyCount[i];
+            maxConsistencyIdx = i;
+        }
+    }
+    for (size_t i = 0; i < NDELIMS; i++) {
+        if (i != maxConsistencyIdx && consistencyCount[i] == maxConsistency) { maxConsistency = 0; }
+    }
+    if (state == DFS_FSM_NO_ENCOUNTERS || maxConsistency == 0) {
+        close(fd);
+        return 0;
+    }
+    ret.delim = DELIMS[maxConsistencyIdx];
+    ret.headerOffset = lastConsistentOffset;
+
+    if (sampleLimitReached) {
+        // The count of the last line that was sampled is the count of the lines before it that are consistent with it
+        ForwardLineReader forwardReader(fd, fileSize, blockSize);
+        size_t runOffset = earliestSampledOffset;
+        int found = findConsistentRun(forwardReader, (int) maxConsistencyIdx, delimCount[maxConsistencyIdx],
+                                      maxSampleLines, earliestSampledOffset, runOffset);
+        ret.bytesRead += forwardReader.bytesRead;
+        ret.usedHeadScan = 1;
+        ret.headerOffset = found ? runOffset : earliestSampledOffset;
+    }
+    close(fd);
+    return 1;
+}
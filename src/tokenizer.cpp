@@ -0,0 +1,134 @@
+/**
+ * Definitions for the quote-aware tokenizer used to split records of delimited data into fields.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <tokenizer.h>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+static inline void emitField(const char *const str, size_t start, size_t end, vector<FieldBounds> &ret) {
+    // Strip the enclosing quotes of a quoted field
+    if (end - start >= 2 && str[start] == '"' && str[end - 1] == '"') {
+        ret.push_back({start + 1, end - 1});
+    } else {
+        ret.push_back({start, end});
+    }
+}
+
+
+#if defined(__SSE2__)
+
+static inline uint64_t matchMask64(const __m128i *const blocks, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    return (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(blocks[0], needle)) |
+           (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(blocks[1], needle)) << 16 |
+           (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(blocks[2], needle)) << 32 |
+           (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(blocks[3], needle)) << 48;
+}
+
+/**
+ * Bit i of the result is the XOR of bits 0 through i of the input, i.e., whether byte i is after an odd number of
+ * quotes.
+ */
+static inline uint64_t prefixXor(uint64_t mask) {
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+#endif  // defined(__SSE2__)
+
+
+size_t tokenizeRecord(const char *const str, size_t len, char delim, vector<FieldBounds> &ret) {
+    size_t fieldStart = 0;
+    size_t pos = 0;
+    bool inQuotes = false;
+
+#if defined(__SSE2__)
+    const size_t blockSize = 64;
+    for (; len - pos >= blockSize; pos += blockSize) {
+        __m128i blocks[4];
+        for (int i = 0; i < 4; i++) {
+            blocks[i] = _mm_loadu_si128((const __m128i *) (str + pos + 16 * i));
+        }
+        uint64_t quoteMask = matchMask64(blocks, '"');
+        uint64_t delimMask = matchMask64(blocks, delim);
+        uint64_t newlineMask = matchMask64(blocks, '\n');
+
+        // A set bit marks a byte between an opening quote (inclusive) and its closing quote (exclusive), if every quote
+        // belongs to a quoted field
+        uint64_t inQuotesMask = prefixXor(quoteMask) ^ (inQuotes ? ~(uint64_t) 0 : 0);
+        uint64_t structural = (delimMask | newlineMask) & ~inQuotesMask;
+
+        // A quote may only open quotes at the start of a field, or right after a closing quote (an escaped quote). Any
+        // other quote is a stray quote within an unquoted field, which is an ordinary byte, so the rest of the record
+        // is left to the byte-at-a-time loop (a quote before the block that is not within quotes is a closing quote)
+        const uint64_t prevInQuotesMask = inQuotesMask << 1 | (uint64_t) inQuotes;
+        const uint64_t openingQuotes = quoteMask & inQuotesMask & ~prevInQuotesMask;
+        const uint64_t closingQuotes = quoteMask & ~inQuotesMask & prevInQuotesMask;
+        const uint64_t fieldStarts = structural << 1 | (uint64_t) (pos == fieldStart);
+        const uint64_t afterClosingQuotes =
+                closingQuotes << 1 | (uint64_t) (pos > 0 && !inQuotes && str[pos - 1] == '"');
+        if (openingQuotes & ~(fieldStarts | afterClosingQuotes)) { break; }
+        inQuotes = (inQuotesMask >> 63) & 1;
+
+        while (structural) {
+            size_t structuralPos = pos + __builtin_ctzll(structural);
+            emitField(str, fieldStart, structuralPos, ret);
+            if (str[structuralPos] == '\n') {
+                return structuralPos + 1;
+            }
+            fieldStart = structuralPos + 1;
+            structural &= structural - 1;
+        }
+    }
+#endif
+
+    // Quotes only have a meaning within fields that start with a quote
+    bool quotedField = fieldStart < pos && str[fieldStart] == '"';
+    for (; pos < len; pos++) {
+        const char c = str[pos];
+        if (c == '"' && (pos == fieldStart || quotedField)) {
+            quotedField = true;
+            inQuotes = !inQuotes;
+        } else if (!inQuotes && (c == delim || c == '\n')) {
+            emitField(str, fieldStart, pos, ret);
+            if (c == '\n') {
+                return pos + 1;
+            }
+            fieldStart = pos + 1;
+            quotedField = false;
+        }
+    }
+    emitField(str, fieldStart, len, ret);
+    return len;
+}
+
+
+void unescapeField(const char *const str, const FieldBounds &bounds, string &ret) {
+    ret.assign(str + bounds.start, bounds.end - bounds.start);
+
+    // Only quoted fields (whose bounds exclude the opening quote) can contain escaped quotes
+    if (bounds.start == 0 || str[bounds.start - 1] != '"') return;
+
+    size_t readPos = ret.find("\"\"");
+    if (readPos == string::npos) return;
+    size_t writePos = readPos;
+    while (readPos < ret.size()) {
+        ret[writePos++] = ret[readPos];
+        readPos += (ret[readPos] == '"' && readPos + 1 < ret.size() && ret[readPos + 1] == '"') ? 2 : 1;
+    }
+    ret.resize(writePos);
+}
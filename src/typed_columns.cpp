@@ -0,0 +1,536 @@
+/**
+ * Definitions for converting classified columns of delimited data into contiguous buffers of typed values.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <typed_columns.h>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+using namespace std;
+
+
+const int64_t NS_PER_SEC = 1000000000;
+const int64_t NS_PER_MIN = 60 * NS_PER_SEC;
+const int64_t NS_PER_HOUR = 60 * NS_PER_MIN;
+const int64_t NS_PER_DAY = 24 * NS_PER_HOUR;
+
+
+MaterializedType getMaterializedType(FieldCls cls) {
+    switch (cls) {
+        case FC_0_LOGICAL:
+            return MT_UINT8;
+        case FC_2_DT_TIME:
+        case FC_3_TM_ONLY:
+        case FC_4_DT_ONLY:
+            return MT_EPOCH_NS;
+        case FC_5_INTEGER:
+            return MT_INT64;
+        case FC_6_FLT_DEC:
+        case FC_7_FLT_EXP:
+            return MT_DOUBLE;
+        default:
+            return MT_STRING;
+    }
+}
+
+
+int parseInt64Field(string_view field, int64_t &ret) {
+    const char *const end = field.data() + field.size();
+    auto result = from_chars(field.data(), end, ret);
+    return result.ec == errc() && result.ptr == end && !field.empty();
+}
+
+
+int parseDoubleField(string_view field, double &ret) {
+    // Only float_exp permits a leading '+', which from_chars does not accept
+    if (!field.empty() && field[0] == '+') {
+        field.remove_prefix(1);
+        if (!field.empty() && field[0] == '-') return 0;
+    }
+    const char *const end = field.data() + field.size();
+    auto result = from_chars(field.data(), end, ret);
+    return result.ec == errc() && result.ptr == end && !field.empty();
+}
+
+
+/**
+ * Days from 1970-01-01 to the given date of the proleptic Gregorian calendar (see
+ * https://howardhinnant.github.io/date_algorithms.html#days_from_civil).
+ */
+static int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yearOfEra = year - era * 400;
+    const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+
+static int daysInMonth(int year, int month) {
+    static const int DAYS[]{31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leapYear ? 29 : DAYS[month - 1];
+}
+
+
+/**
+ * Recursive descent parser for the date and time rules of the grammar (see grammar.cpp). Each method matches one rule
+ * at the current position and either advances past it and returns true, or leaves the position unchanged and returns
+ * false. Alternatives are tried in the grammar's order and the first that matches is kept, as mpc does; regex
+ * alternatives that mpc can never reach (see `GrammarDfa`) are left out.
+ */
+class DateTimeParser {
+private:
+    const char *_pos;
+    const char *const _end;
+
+    bool peekDigit(size_t offset, char lo = '0', char hi = '9') const {
+        return _end - _pos > (ptrdiff_t) offset && _pos[offset] >= lo && _pos[offset] <= hi;
+    }
+
+    bool lit(char c) {
+        if (_pos == _end || *_pos != c) return false;
+        _pos++;
+        return true;
+    }
+
+    bool lit(const char *str) {
+        const size_t len = strlen(str);
+        if ((size_t) (_end - _pos) < len || memcmp(_pos, str, len) != 0) return false;
+        _pos += len;
+        return true;
+    }
+
+    bool digits(size_t n, int &ret) {
+        for (size_t i = 0; i < n; i++) {
+            if (!peekDigit(i)) return false;
+        }
+        ret = 0;
+        for (size_t i = 0; i < n; i++) {
+            ret = ret * 10 + (*_pos++ - '0');
+        }
+        return true;
+    }
+
+    /**
+     * Two-digit number whose first digit is between `lo` and `hi`.
+     */
+    bool twoDigits(char lo, char hi, int &ret) {
+        if (!peekDigit(0, lo, hi) || !peekDigit(1)) return false;
+        return digits(2, ret);
+    }
+
+    bool oneOfTwoDigits(const char *const *options, int &ret) {
+        for (; *options != nullptr; options++) {
+            if (lit(*options)) {
+                ret = (*options)[0] * 10 + (*options)[1] - '0' * 11;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool year4(int &ret) { return digits(4, ret); }
+
+    bool year2(int &ret) {
+        if (!digits(2, ret)) return false;
+        ret += ret < 69 ? 2000 : 1900;
+        return true;
+    }
+
+    // day: /[0-2][0-9]|30|31/
+    bool day(int &ret) {
+        static const char *const OPTIONS[]{"30", "31", nullptr};
+        return twoDigits('0', '2', ret) || oneOfTwoDigits(OPTIONS, ret);
+    }
+
+    // day_single_dig: /[1-9]|.../ (the other alternatives are never reached)
+    bool daySingleDig(int &ret) {
+        if (!peekDigit(0, '1', '9')) return false;
+        return digits(1, ret);
+    }
+
+    // month_m: /0[0-9]|10|11|12/
+    bool monthM(int &ret) {
+        static const char *const OPTIONS[]{"10", "11", "12", nullptr};
+        return twoDigits('0', '0', ret) || oneOfTwoDigits(OPTIONS, ret);
+    }
+
+    // month_b: /Jan|Feb|.../
+    bool monthB(int &ret) {
+        static const char *const NAMES[]{"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov",
+                                         "Dec"};
+        for (int i = 0; i < 12; i++) {
+            if (lit(NAMES[i])) {
+                ret = i + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // month_single_dig: /[1-9]|.../ (the other alternatives are never reached)
+    bool monthSingleDig(int &ret) { return daySingleDig(ret); }
+
+    bool monthAny(int &ret) { return monthM(ret) || monthB(ret) || monthSingleDig(ret); }
+
+    bool dayAny(int &ret) { return day(ret) || daySingleDig(ret); }
+
+    bool dateSep() { return lit('-') || lit('/'); }
+
+    // second, minute: /[0-5][0-9]/
+    bool sixty(int &ret) { return twoDigits('0', '5', ret); }
+
+    // hour_12: /0[1-9]|10|11|12/
+    bool hour12(int &ret) {
+        static const char *const OPTIONS[]{"10", "11", "12", nullptr};
+        if (peekDigit(0, '0', '0') && peekDigit(1, '1', '9')) return digits(2, ret);
+        return oneOfTwoDigits(OPTIONS, ret);
+    }
+
+    // hour_24: /[0-1][0-9]|20|21|22|23/
+    bool hour24(int &ret) {
+        static const char *const OPTIONS[]{"20", "21", "22", "23", nullptr};
+        return twoDigits('0', '1', ret) || oneOfTwoDigits(OPTIONS, ret);
+    }
+
+    // hour_12_single_dig: /[1-9]|.../ (the other alternatives are never reached)
+    bool hour12SingleDig(int &ret) { return daySingleDig(ret); }
+
+    // hour_24_single_dig: /[0-1]|1[0-9]|20|21|22|23/ (1[0-9] is never reached)
+    bool hour24SingleDig(int &ret) {
+        static const char *const OPTIONS[]{"20", "21", "22", "23", nullptr};
+        if (peekDigit(0, '0', '1')) return digits(1, ret);
+        return oneOfTwoDigits(OPTIONS, ret);
+    }
+
+    // fsecond: /\.[0-9]+/
+    bool fsecond(int64_t &ret) {
+        if (!(_end - _pos >= 2 && _pos[0] == '.' && peekDigit(1))) return false;
+        _pos++;
+        ret = 0;
+        int64_t scale = NS_PER_SEC;
+        for (; _pos != _end && *_pos >= '0' && *_pos <= '9'; _pos++) {
+            scale /= 10;
+            ret += (*_pos - '0') * scale;
+        }
+        return true;
+    }
+
+    // apm: /[AP]M/
+    bool apm(bool &pm) {
+        if (lit("AM")) {
+            pm = false;
+            return true;
+        }
+        if (lit("PM")) {
+            pm = true;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Parse a time zone offset of the form [+-]HH followed by `sep` and MM (or by nothing if `sep` is '\0' and
+     * `withMinutes` is false).
+     */
+    bool tzOffset(bool withMinutes, char sep, int64_t &ret) {
+        const char *const start = _pos;
+        if (_pos == _end || (*_pos != '+' && *_pos != '-')) return false;
+        const bool negative = *_pos++ == '-';
+        int hours, minutes = 0;
+        if (!digits(2, hours) || (withMinutes && ((sep != '\0' && !lit(sep)) || !digits(2, minutes)))) {
+            _pos = start;
+            return false;
+        }
+        ret = (negative ? -1 : 1) * (hours * NS_PER_HOUR + minutes * NS_PER_MIN);
+        return true;
+    }
+
+    // (<tz_q> | <tz_Q> | ' '<tz_ZP>)
+    bool tz(int64_t &ret) {
+        if (tzOffset(true, '\0', ret) || tzOffset(true, ':', ret)) return true;
+        const char *const start = _pos;
+        if (lit(' ') && _end - _pos >= 3 && isupper(_pos[0]) && isupper(_pos[1]) && isupper(_pos[2])) {
+            _pos += 3;
+            if (tzOffset(false, '\0', ret)) return true;
+        }
+        _pos = start;
+        return false;
+    }
+
+    /**
+     * The remainder of a time after its hour: `minute second` or `':' minute (':' second fsecond?)?` (depending on
+     * `colons`), then an optional (or, if `apmRequired`, required) AM/PM and a time zone (required if `tzRequired`).
+     */
+    bool timeRest(int hour, bool colons, bool apmRequired, bool tzRequired, int64_t &nsOfDay, int64_t &tzRet) {
+        int minute, second = 0;
+        int64_t fraction = 0;
+        if (colons) {
+            if (!lit(':') || !sixty(minute)) return false;
+            const char *const secondStart = _pos;
+            if (lit(':')) {
+                if (sixty(second)) {
+                    fsecond(fraction);
+                } else {
+                    _pos = secondStart;
+                }
+            }
+        } else {
+            if (!sixty(minute) || !sixty(second)) return false;
+            fsecond(fraction);
+        }
+
+        const char *const apmStart = _pos;
+        lit(' ');
+        bool pm = false;
+        const bool hasApm = apm(pm);
+        if (!hasApm) {
+            if (apmRequired) return false;
+            _pos = apmStart;
+        }
+
+        tzRet = 0;
+        if (!tz(tzRet) && tzRequired) return false;
+
+        if (hasApm) {
+            if (hour > 12) return false;
+            hour = hour % 12 + (pm ? 12 : 0);
+        }
+        nsOfDay = hour * NS_PER_HOUR + minute * NS_PER_MIN + second * NS_PER_SEC + fraction;
+        return true;
+    }
+
+    bool time(int64_t &nsOfDay, int64_t &tzRet) {
+        const char *const start = _pos;
+        int hour;
+
+        // <hour_12><minute><second><fsecond>?' '?<apm>(...)?
+        if (hour12(hour) && timeRest(hour, false, true, false, nsOfDay, tzRet)) return true;
+        _pos = start;
+
+        // (<hour_12> | <hour_12_single_dig>)':'<minute>(':'<second><fsecond>?)?' '?<apm>(...)?
+        if ((hour12(hour) || hour12SingleDig(hour)) && timeRest(hour, true, true, false, nsOfDay, tzRet)) return true;
+        _pos = start;
+
+        // <hour_24><minute><second><fsecond>?(' '?<apm>)?(...)
+        if (hour24(hour) && timeRest(hour, false, false, true, nsOfDay, tzRet)) return true;
+        _pos = start;
+
+        // (<hour_24> | <hour_24_single_dig>)':'<minute>(':'<second><fsecond>?)?(' '?<apm>)?(...)?
+        if ((hour24(hour) || hour24SingleDig(hour)) && timeRest(hour, true, false, false, nsOfDay, tzRet)) return true;
+        _pos = start;
+        return false;
+    }
+
+    bool date(int &year, int &month, int &dayRet) {
+        const char *const start = _pos;
+
+        // <year_4_digit><month_m><day>
+        if (year4(year) && monthM(month) && day(dayRet)) return true;
+        _pos = start;
+
+        // <month_m><day><year_2_digit>
+        if (monthM(month) && day(dayRet) && year2(year)) return true;
+        _pos = start;
+
+        // <day><month_m><year_2_digit>
+        if (day(dayRet) && monthM(month) && year2(year)) return true;
+        _pos = start;
+
+        // (<month_m> | <month_b> | <month_single_dig>)('-' | '/')(<day> | <day_single_dig>)('-' | '/')
+        // (<year_4_digit> | <year_2_digit>)
+        if (monthAny(month) && dateSep() && dayAny(dayRet) && dateSep() && (year4(year) || year2(year))) return true;
+        _pos = start;
+
+        // <year_4_digit>('-' | '/')(<month_m> | <month_b> | <month_single_dig>)('-' | '/')(<day> | <day_single_dig>)
+        if (year4(year) && dateSep() && monthAny(month) && dateSep() && dayAny(dayRet)) return true;
+        _pos = start;
+        return false;
+    }
+
+public:
+    DateTimeParser(const char *str, size_t len) : _pos(str), _end(str + len) {}
+
+    /**
+     * Parse `(<datetime> | <time> | <date>)` followed by the end of the string.
+     */
+    bool parse(int64_t &ret) {
+        const char *const start = _pos;
+        int year, month, dayOfMonth;
+        int64_t nsOfDay = 0, tzRet = 0;
+        bool hasDate = false;
+
+        // <date>(' ' | 'T')?<time>
+        if (date(year, month, dayOfMonth)) {
+            if (!lit(' ')) lit('T');
+            hasDate = time(nsOfDay, tzRet);
+        }
+        if (!hasDate) {
+            _pos = start;
+            if (!time(nsOfDay, tzRet)) {
+                hasDate = date(year, month, dayOfMonth);
+                if (!hasDate) return false;
+            }
+        }
+        if (_pos != _end) return false;
+
+        int64_t days = 0;
+        if (hasDate) {
+            if (month < 1 || month > 12 || dayOfMonth < 1 || dayOfMonth > daysInMonth(year, month)) return false;
+            days = daysFromCivil(year, month, dayOfMonth);
+        }
+        ret = days * NS_PER_DAY + nsOfDay - tzRet;
+        return true;
+    }
+};
+
+
+int parseEpochNsField(string_view field, int64_t &ret) {
+    return DateTimeParser(field.data(), field.size()).parse(ret);
+}
+
+
+/**
+ * Convert one field and append it to the column.
+ */
+static void appendField(TypedColumn &column, const string_view *field, size_t rowIdx) {
+    bool converted = field != nullptr && !field->empty();
+    switch (column.type) {
+        case MT_UINT8: {
+            converted = converted && field->size() == 1 && ((*field)[0] == '0' || (*field)[0] == '1');
+            column.uint8Values.push_back(converted ? (*field)[0] - '0' : 0);
+            break;
+        }
+        case MT_INT64: {
+            int64_t value = 0;
+            converted = converted && parseInt64Field(*field, value);
+            column.int64Values.push_back(converted ? value : 0);
+            break;
+        }
+        case MT_DOUBLE: {
+            double value = 0;
+            converted = converted && parseDoubleField(*field, value);
+            column.doubleValues.push_back(converted ? value : 0);
+            break;
+        }
+        case MT_EPOCH_NS: {
+            int64_t value = 0;
+            converted = converted && parseEpochNsField(*field, value);
+            column.int64Values.push_back(converted ? value : 0);
+            break;
+        }
+        default: {
+            // Any field can be a string, but a missing one is still a failure
+            converted = field != nullptr;
+            column.stringValues.emplace_back(converted ? *field : string_view());
+            break;
+        }
+    }
+    column.isValid.push_back(converted);
+    if (!converted) {
+        if (column.numFailures++ == 0) {
+            column.firstFailureRow = rowIdx;
+        }
+    }
+}
+
+
+static void initColumns(const vector<tuple<string, FieldCls>> &classifications, size_t numDataRows,
+                        vector<TypedColumn> &ret) {
+    ret.clear();
+    ret.reserve(classifications.size());
+    for (const auto &classification: classifications) {
+        TypedColumn column{get<0>(classification), get<1>(classification), getMaterializedType(get<1>(classification)),
+                           {}, {}, {}, {}, {}, 0, (size_t) -1};
+        switch (column.type) {
+            case MT_UINT8:
+                column.uint8Values.reserve(numDataRows);
+                break;
+            case MT_INT64:
+            case MT_EPOCH_NS:
+                column.int64Values.reserve(numDataRows);
+                break;
+            case MT_DOUBLE:
+                column.doubleValues.reserve(numDataRows);
+                break;
+            default:
+                column.stringValues.reserve(numDataRows);
+                break;
+        }
+        column.isValid.reserve(numDataRows);
+        ret.push_back(std::move(column));
+    }
+}
+
+
+static int getMaterializeStatus(const vector<TypedColumn> &columns) {
+    for (const auto &column: columns) {
+        if (column.numFailures > 0) return 0;
+    }
+    return 1;
+}
+
+
+int materializeColumns(const ColumnarFields &fields, const vector<tuple<string, FieldCls>> &classifications,
+                       vector<TypedColumn> &ret) {
+    if (fields.getNumRows() == 0 || classifications.size() != fields.getNumColumns()) {
+        ret.clear();
+        return -1;
+    }
+    const size_t numDataRows = fields.getNumRows() - 1;
+    initColumns(classifications, numDataRows, ret);
+
+    // The fields of each column are contiguous, so each column is converted with a linear scan
+    for (size_t columnIdx = 0; columnIdx < ret.size(); columnIdx++) {
+        for (size_t rowIdx = 1; rowIdx <= numDataRows; rowIdx++) {
+            if (columnIdx < fields.getNumFields(rowIdx)) {
+                string_view field = fields.getField(rowIdx, columnIdx);
+                appendField(ret[columnIdx], &field, rowIdx - 1);
+            } else {
+                appendField(ret[columnIdx], nullptr, rowIdx - 1);
+            }
+        }
+    }
+    return getMaterializeStatus(ret);
+}
+
+
+template<typename FieldT>
+static int materializeColumnsImpl(const vector<vector<FieldT>> &rows,
+                                  const vector<tuple<string, FieldCls>> &classifications, vector<TypedColumn> &ret) {
+    if (rows.empty() || classifications.size() != rows[0].size()) {
+        ret.clear();
+        return -1;
+    }
+    const size_t numDataRows = rows.size() - 1;
+    initColumns(classifications, numDataRows, ret);
+
+    for (size_t columnIdx = 0; columnIdx < ret.size(); columnIdx++) {
+        for (size_t rowIdx = 1; rowIdx <= numDataRows; rowIdx++) {
+            if (columnIdx < rows[rowIdx].size()) {
+                string_view field = rows[rowIdx][columnIdx];
+                appendField(ret[columnIdx], &field, rowIdx - 1);
+            } else {
+                appendField(ret[columnIdx], nullptr, rowIdx - 1);
+            }
+        }
+    }
+    return getMaterializeStatus(ret);
+}
+
+
+int materializeColumns(const vector<vector<string>> &rows, const vector<tuple<string, FieldCls>> &classifications,
+                       vector<TypedColumn> &ret) {
+    return materializeColumnsImpl(rows, classifications, ret);
+}
+
+
+int materializeColumns(const vector<vector<string_view>> &rows,
+                       const vector<tuple<string, FieldCls>> &classifications, vector<TypedColumn> &ret) {
+    return materializeColumnsImpl(rows, classifications, ret);
+}
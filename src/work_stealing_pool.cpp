@@ -0,0 +1,126 @@
+/**
+ * Definitions for the work-stealing thread pool.
+ *
+ * @author Duncan Mazza
+ */
+
+#include <work_stealing_pool.h>
+#include <algorithm>
+
+using namespace std;
+
+
+// The pool (and the index within it) of the worker running on this thread, if any
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local size_t currentWorkerIdx = 0;
+
+
+WorkStealingPool::WorkStealingPool(size_t numThreads) :
+        _numQueued(0), _numUnfinished(0), _stopping(false), _nextQueue(0), _numSteals(0) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, thread::hardware_concurrency());
+    }
+    for (size_t workerIdx = 0; workerIdx < numThreads; workerIdx++) {
+        _queues.push_back(make_unique<WorkerQueue>());
+    }
+    for (size_t workerIdx = 0; workerIdx < numThreads; workerIdx++) {
+        _workers.emplace_back(&WorkStealingPool::runWorker, this, workerIdx);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _taskAvailable.notify_all();
+    for (auto &worker: _workers) {
+        worker.join();
+    }
+}
+
+
+void WorkStealingPool::submit(function<void()> task) {
+    // Count the task before queueing it, so that a worker that sees no queued tasks can safely go to sleep
+    {
+        lock_guard<mutex> lock(_mutex);
+        _numQueued++;
+        _numUnfinished++;
+    }
+
+    const size_t queueIdx = currentPool == this ? currentWorkerIdx : _nextQueue++ % _queues.size();
+    {
+        lock_guard<mutex> lock(_queues[queueIdx]->queueMutex);
+        _queues[queueIdx]->tasks.push_back(std::move(task));
+    }
+    _taskAvailable.notify_one();
+}
+
+
+int WorkStealingPool::takeTask(size_t workerIdx, function<void()> &ret) {
+    {
+        WorkerQueue &ownQueue = *_queues[workerIdx];
+        lock_guard<mutex> lock(ownQueue.queueMutex);
+        if (!ownQueue.tasks.empty()) {
+            ret = std::move(ownQueue.tasks.back());
+            ownQueue.tasks.pop_back();
+            return 1;
+        }
+    }
+    for (size_t offset = 1; offset < _queues.size(); offset++) {
+        WorkerQueue &otherQueue = *_queues[(workerIdx + offset) % _queues.size()];
+        lock_guard<mutex> lock(otherQueue.queueMutex);
+        if (!otherQueue.tasks.empty()) {
+            ret = std::move(otherQueue.tasks.front());
+            otherQueue.tasks.pop_front();
+            _numSteals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+void WorkStealingPool::runWorker(size_t workerIdx) {
+    currentPool = this;
+    currentWorkerIdx = workerIdx;
+
+    function<void()> task;
+    while (true) {
+        if (takeTask(workerIdx, task)) {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _numQueued--;
+            }
+            task();
+            task = nullptr;
+
+            lock_guard<mutex> lock(_mutex);
+            if (--_numUnfinished == 0) {
+                _allDone.notify_all();
+            }
+            continue;
+        }
+
+        // A queued task that could not be taken yet is still being pushed by `submit`, so only sleep once there are none
+        unique_lock<mutex> lock(_mutex);
+        _taskAvailable.wait(lock, [this]() { return _numQueued > 0 || _stopping; });
+        if (_stopping && _numQueued == 0) { return; }
+    }
+}
+
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> lock(_mutex);
+    _allDone.wait(lock, [this]() { return _numUnfinished == 0; });
+}
+
+
+size_t WorkStealingPool::getNumThreads() const {
+    return _workers.size();
+}
+
+size_t WorkStealingPool::getNumSteals() const {
+    return _numSteals;
+}
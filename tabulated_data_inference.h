@@ -7,40 +7,28 @@
 #ifndef TABULATED_DATA_INFERENCE_H
 #define TABULATED_DATA_INFERENCE_H
 
-#include <boost/algorithm/string.hpp>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <grammar.h>
+#include <field_cls.h>
+#include <fast_classify.h>
+#include <grammar_dfa.h>
+#include <mapped_file.h>
+#include <work_stealing_pool.h>
+#include <columnar_fields.h>
+#include <field_cls_cache.h>
+#include <inference_stats.h>
+#include <schema_cache.h>
+#include <column_sketch.h>
 
 using namespace std;
 
-typedef enum {
-    FC_0_LOGICAL,  // boolean values
-    FC_1_BIT_STR,  // bit string
-    FC_2_DT_TIME,  // datetime string
-    FC_3_TM_ONLY,  // time string
-    FC_4_DT_ONLY,  // date string
-    FC_5_INTEGER,  // integer
-    FC_6_FLT_DEC,  // floating point (decimal notation)
-    FC_7_FLT_EXP,  // floating point (scientific notation)
-    FC_8_ARBITRY,  // arbitrary string
-} FieldCls;
-const int NUM_FC = 9;
-
-const char *const FieldClsCorrespondingNames[]{
-        "logical",
-        "bit_str",
-        "datetime",
-        "time",
-        "date",
-        "int",
-        "float_dec",
-        "float_exp",
-        "arbitrary",
-};
-
 
 /**
  * Wrapper for creating and cleaning up mpc_parser_t pointers.
@@ -48,11 +36,69 @@ const char *const FieldClsCorrespondingNames[]{
 class MpcParserTWrapper {
 private:
     mpc_parser_t* _parser;
+    mpc_parser_t* _groupParsers[NUM_GG];
     vector<mpc_parser_t*> _allParsers;
 public:
     MpcParserTWrapper();
     virtual ~MpcParserTWrapper();
     mpc_parser_t *getParserPtr() const;
+
+    /**
+     * @return The parser of one alternative of the `all` rule on its own (see `mpc_setup`).
+     */
+    mpc_parser_t *getGroupParserPtr(GrammarGroup group) const;
+};
+
+
+/**
+ * Thread-safe pool of parser objects, so that the grammar is compiled (which takes far longer than classifying a small
+ * file) only when no previously compiled parser is idle, rather than once per call.
+ *
+ * @note A parser is used by one thread at a time: `acquire` hands out an idle parser (or compiles a new one if every
+ *  parser is in use), and the parser goes back to the pool when the returned lease is destroyed. The number of parsers
+ *  compiled is therefore the largest number of leases held at the same time.
+ */
+class MpcParserPool {
+private:
+    mutex _mutex;
+    vector<unique_ptr<MpcParserTWrapper>> _idleParsers;
+    size_t _numCompiled;
+public:
+    /**
+     * Exclusive use of a parser from a pool, which is returned to the pool on destruction.
+     */
+    class Lease {
+    private:
+        MpcParserPool *_pool;
+        unique_ptr<MpcParserTWrapper> _parser;
+    public:
+        Lease(MpcParserPool &pool, unique_ptr<MpcParserTWrapper> parser);
+        Lease(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease &operator=(Lease &&) = delete;
+        virtual ~Lease();
+        MpcParserTWrapper &get() const;
+    };
+
+    MpcParserPool();
+    MpcParserPool(const MpcParserPool &) = delete;
+    MpcParserPool &operator=(const MpcParserPool &) = delete;
+
+    /**
+     * @note The pool must outlive the returned lease.
+     *
+     * @return A lease of an idle parser, which is compiled first if there is none.
+     */
+    Lease acquire();
+
+    size_t getNumCompiled();
+    size_t getNumIdle();
+
+    /**
+     * @return A process-wide pool, which is used by the functions that don't take a parser as an argument.
+     */
+    static MpcParserPool &global();
 };
 
 
@@ -62,27 +108,63 @@ public:
  * @note Assume that the delimiter is one of the following: comma, semicolon, space, or (horizontal) tab.
  * @note This function works by identifying which of the possible delimiter characters remains the most consistent in
  *  occurrences-per-line starting from the end of the file. Empty lines are ignored.
+ * @note Quotes are not taken into account: a delimiter within a quoted field is counted like any other, so a line with
+ *  one may end the consistent lines early (i.e., be taken as the header).
  *
  * @param lines Vector of strings where each string is a line in the data file
+ * @param stats If not null, the statistics to which the time and lines scanned by delimiter detection are added.
  * @return Tuple containing the delimiter found and the index of the last non-empty line identified as consistently
  *  using the delimiter. If a delimiter could not be successfully inferred, then the '\0' character is returned as the
  *  delimiter.
  */
-tuple<char, size_t> getDelim(const vector<string> &lines);
+tuple<char, size_t> getDelim(const vector<string> &lines, InferenceStats *stats = nullptr);
+
+/**
+ * Overload of `getDelim` for lines that are views into a buffer (e.g., a `MappedFile`) instead of owned strings.
+ */
+tuple<char, size_t> getDelim(const vector<string_view> &lines, InferenceStats *stats = nullptr);
 
 /**
  * Given a vector of strings and a delimiter, acquire each of the fields in each column as a vector of vector of
  * strings.
  *
+ * @note Fields may be quoted as in RFC 4180 (see `tokenizeRecord`): delimiters within double quotes do not split a
+ *  field, the enclosing quotes are removed, and escaped double quotes ("") are replaced with a single double quote.
+ * @note Each line is tokenized on its own, so a quoted field that spans lines (which RFC 4180 allows) is split at its
+ *  newlines into fields of separate rows, which usually makes the number of fields inconsistent.
+ *
  * @param lines Vector of strings where each string is a line in the data file
  * @param ret Vector to which each line's fields are appended as a vector
  * @param delim Data delimiter
  * @param stopAt Stop acquiring fields from the data when this number + 1 of non-empty lines is reached (iteration happens
  * from the end of `lines`; this value can be thought of as the index of nonempty lines that reverse iteration stops at
  * when acquiring fields).
+ * @param stats If not null, the statistics to which the time and lines scanned by field splitting are added, and whose
+ *  peak field storage is raised to the memory used by `ret` if that is larger.
  * @return 1 if a consistent number of fields was found in every non-empty line and 0 if not.
  */
-int getFields(const vector<string> &lines, char delim, vector<vector<string>> &ret, size_t stopAt = -1);
+int getFields(const vector<string> &lines, char delim, vector<vector<string>> &ret, size_t stopAt = -1,
+              InferenceStats *stats = nullptr);
+
+/**
+ * Overload of `getFields` for lines that are views into a buffer. The returned fields are views into the same buffer,
+ * so no field is copied. As a consequence, escaped double quotes within quoted fields are left as they are.
+ */
+int getFields(const vector<string_view> &lines, char delim, vector<vector<string_view>> &ret, size_t stopAt = -1,
+              InferenceStats *stats = nullptr);
+
+/**
+ * Overload of `getFields` that stores the fields column by column in a single arena (see `ColumnarFields`) instead of
+ * allocating a string for each field and a vector for each row.
+ *
+ * @note Fields are copied into the arena with escaped double quotes replaced, as for the `std::string` overload.
+ *
+ * @param ret Set to the fields of the lines (any previous contents are discarded)
+ */
+int getFields(const vector<string> &lines, char delim, ColumnarFields &ret, size_t stopAt = -1,
+              InferenceStats *stats = nullptr);
+int getFields(const vector<string_view> &lines, char delim, ColumnarFields &ret, size_t stopAt = -1,
+              InferenceStats *stats = nullptr);
 
 
 /**
@@ -92,6 +174,7 @@ int getFields(const vector<string> &lines, char delim, vector<vector<string>> &r
  * one of the strings in `FieldClsCorrespondingNames`, which in turn correspond to values in the `FieldCls` enumeration.
  * If there is no matching string in `FieldClsCorrespondingNames`, or if the `mpcResultRet` argument is 0, then the
  * default return value is `FC_8_ARBITRY`.
+ * @note The abstract syntax tree (or error) of the result is not freed.
  *
  * @param mpcResult Result from parsing a string with the mpc parser combinator.
  * @param mpcResultRet The integer returned by `mpc_parse`.
@@ -101,7 +184,178 @@ FieldCls extractFieldClsFromParser(const mpc_result_t *mpcResult, int mpcResultR
 
 
 /**
- * Wrapper for the `classifyColumns` function that automatically creates (and discards) a parser object.
+ * Engines with which fields can be classified.
+ */
+typedef enum {
+    CE_MPC,  // The mpc parser (after the `fastClassifyField` fast path for numeric and boolean fields)
+    CE_DFA,  // The automaton compiled from the grammar (see `GrammarDfa`); recognize-only, i.e., no syntax tree is built
+    // and no memory is allocated
+} ClassificationEngine;
+
+
+/**
+ * Classify a single field of data. With the mpc engine, fields that `fastClassifyField` can classify (most numeric and
+ * boolean fields) are classified without the mpc parser; all other fields are parsed with it.
+ *
+ * @note The mpc parser always builds an abstract syntax tree, from which only the tag of the matched rule is read
+ *  before it is freed. Use the DFA engine to classify without building a tree.
+ *
+ * @param field The string to classify
+ * @param parser An object containing the mpc parser with which the string is parsed (unused by the DFA engine).
+ * @param engine The engine with which the field is classified.
+ * @param cache If not null, a cache of previously parsed values that is consulted before (and filled after) parsing
+ *  with mpc. Fields classified by the fast path or by the DFA engine are not cached, as they are classified in a single
+ *  pass that costs about as much as hashing them.
+ * @param stats If not null, the statistics to which the field (and the time taken to parse it with mpc, if it was) is
+ *  added.
+ * @return The most restrictive data classification that fits the field.
+ */
+FieldCls classifyField(string_view field, MpcParserTWrapper &parser, ClassificationEngine engine = CE_MPC,
+                       FieldClsCache *cache = nullptr, InferenceStats *stats = nullptr);
+
+
+/**
+ * Classify a field of a column and give the column's classification with the field folded in, i.e.,
+ * `max(columnCls, classifyField(field, ...))`, with fewer alternatives of the grammar tried than `classifyField` would.
+ *
+ * @note Fields that need mpc are first parsed with the rule of the group of `columnCls` alone (see `GrammarGroup`), so
+ *  a field that fits the column's current classification (the common case) is parsed with one alternative instead of
+ *  every alternative before it. Only if the field fits a less restrictive classification in that group, or doesn't fit
+ *  the group at all, are the earlier groups tried (a match in one of which leaves the column unchanged) and then the
+ *  later groups in order (the first match of which widens the column).
+ * @note With a cache, only fields whose own classification was found are inserted, which excludes fields that fit the
+ *  column's group with a classification no less restrictive than that of the column.
+ *
+ * @param field The string to classify
+ * @param columnCls The classification of the column given the fields seen before this one
+ * @param parser An object containing the mpc parsers with which the string is parsed (unused by the DFA engine).
+ * @param engine The engine with which the field is classified. The DFA engine classifies the field in full.
+ * @param cache If not null, a cache of previously parsed values (see `classifyField`).
+ * @param stats If not null, the statistics to which the field (and each parse with mpc) is added.
+ * @return The least restrictive of `columnCls` and the classification of the field.
+ */
+FieldCls classifyFieldInColumn(string_view field, FieldCls columnCls, MpcParserTWrapper &parser,
+                               ClassificationEngine engine = CE_MPC, FieldClsCache *cache = nullptr,
+                               InferenceStats *stats = nullptr);
+
+
+/**
+ * Stateful column classifier that is given the column names once and is then fed rows of data one at a time (or in
+ * chunks of rows) as they are read or received.
+ *
+ * @note Only the column names and the running per-column classification are stored, so memory usage stays constant
+ *  regardless of how many rows are fed to the classifier.
+ * @note Once a column is classified as `FC_8_ARBITRY` (the least restrictive classification) its classification can
+ *  no longer change, so its fields are no longer parsed. Callers can stop feeding rows once `isSaturated` is true.
+ * @note It is the caller's responsibility to manage the memory for the parser, which must outlive this object.
+ */
+class ColumnClassifier {
+private:
+    MpcParserTWrapper &_parser;
+    ClassificationEngine _engine;
+    vector<string> _columnNames;
+    vector<FieldCls> _fieldClasses;
+    size_t _numRows;
+    size_t _numSaturated;
+    size_t _numSkippedParses;
+    vector<FieldClsCache> _caches;
+    vector<ColumnSketch> _sketches;
+    InferenceStats *_stats;
+
+    template<typename FieldT>
+    int pushRowImpl(const vector<FieldT> &row);
+public:
+    /**
+     * @param header The column names
+     * @param parser An object containing the mpc parser with which each string of data is parsed.
+     * @param engine The engine with which each string of data is classified.
+     */
+    ColumnClassifier(const vector<string> &header, MpcParserTWrapper &parser, ClassificationEngine engine = CE_MPC);
+    ColumnClassifier(const vector<string_view> &header, MpcParserTWrapper &parser,
+                     ClassificationEngine engine = CE_MPC);
+
+    /**
+     * Give each column a cache of the classifications of the values that were parsed (see `FieldClsCache`), which
+     * replaces the parsing of repeated values in low-cardinality columns with a hash lookup.
+     *
+     * @param maxEntriesPerColumn Maximum number of distinct values (or shapes) cached per column
+     * @param keyType What the caches are keyed by
+     */
+    void enableCache(size_t maxEntriesPerColumn, CacheKeyType keyType = CK_VALUE);
+
+    /**
+     * @param stats If not null, the statistics to which each classified field is added (see `classifyField`). The
+     *  object must outlive its use by this classifier.
+     */
+    void setStats(InferenceStats *stats);
+
+    /**
+     * Give each column a `ColumnSketch` to which every field pushed from then on is added, including the fields of
+     * columns that are saturated (which are still not parsed).
+     */
+    void enableSketches();
+
+    /**
+     * Classify each field of a row of data and fold the results into the running per-column classification.
+     *
+     * @note If the row has a different number of fields than the header, then only the fields that have a
+     *  corresponding column are classified.
+     *
+     * @param row The fields of one row of data
+     * @return 1 if the row had the same number of fields as the header and 0 if not.
+     */
+    int pushRow(const vector<string> &row);
+    int pushRow(const vector<string_view> &row);
+
+    /**
+     * Push each of the given rows with `pushRow`.
+     *
+     * @param rows A chunk of rows of data (not including the header)
+     * @return The number of rows that had the same number of fields as the header.
+     */
+    size_t pushRows(const vector<vector<string>> &rows);
+    size_t pushRows(const vector<vector<string_view>> &rows);
+
+    size_t getNumColumns() const;
+    size_t getNumRows() const;
+    const vector<FieldCls> &getFieldClasses() const;
+
+    /**
+     * @return Whether every column has been classified as `FC_8_ARBITRY`, in which case pushing more rows has no effect
+     *  on the classifications.
+     */
+    bool isSaturated() const;
+
+    /**
+     * @return The number of fields that were not parsed because their column had already been classified as
+     *  `FC_8_ARBITRY`.
+     */
+    size_t getNumSkippedParses() const;
+
+    /**
+     * @return The number of lookups that were answered (or not answered) by the per-column caches, summed over all
+     *  columns (0 if the caches are not enabled).
+     */
+    size_t getNumCacheHits() const;
+    size_t getNumCacheMisses() const;
+
+    /**
+     * @return The sketch of each column (empty if sketches are not enabled).
+     */
+    const vector<ColumnSketch> &getSketches() const;
+
+    /**
+     * Append the column names and their classifications given the rows pushed so far.
+     *
+     * @param classifications A vector to which tuples are appended where each tuple contains as its first entry the
+     *  column name and its second entry the column classification.
+     */
+    void getClassifications(vector<tuple<string, FieldCls>> &classifications) const;
+};
+
+
+/**
+ * Wrapper for the `classifyColumns` function that automatically leases a parser object from `MpcParserPool::global`.
  *
  * @param rows A vector of at least length 1 where each element corresponds to a row of data. The first row is
  *  expected to contain the column names.
@@ -123,9 +377,431 @@ void classifyColumnsAutoSetup(const vector<vector<string>> &rows, vector<tuple<s
  * @param classifications A vector of tuples where each tuple contains as its first entry the column name and its second
  *  entry the column classification.
  * @param parser An object containing the mpc parser with which each string of data is parsed.
+ * @param numSkippedParses If not null, set to the number of fields that were not parsed because their column had
+ *  already been classified as `FC_8_ARBITRY`. Rows are no longer read once every column is classified as such.
+ * @param engine The engine with which each string of data is classified.
+ * @param cacheSize If nonzero, the maximum number of distinct values per column whose classification is cached (see
+ *  `ColumnClassifier::enableCache`).
+ * @param cacheKeyType What the per-column caches are keyed by (unused if `cacheSize` is 0).
+ * @param stats If not null, the statistics to which the time taken by classification and each classified field are
+ *  added.
+ * @param sketches If not null, set to the sketch of each column (see `ColumnSketch`), which are collected in the same
+ *  pass over the fields. Every row is then read, even once every column is classified as `FC_8_ARBITRY`.
  */
 void classifyColumns(const vector<vector<string>> &rows, vector<tuple<string, FieldCls>> &classifications,
-                     MpcParserTWrapper &parser);
+                     MpcParserTWrapper &parser, size_t *numSkippedParses = nullptr,
+                     ClassificationEngine engine = CE_MPC, size_t cacheSize = 0,
+                     CacheKeyType cacheKeyType = CK_VALUE, InferenceStats *stats = nullptr,
+                     vector<ColumnSketch> *sketches = nullptr);
+
+/**
+ * Overload of `classifyColumns` for rows of fields that are views into a buffer. Fields are parsed in place, so only the
+ * column names are copied into `classifications`.
+ */
+void classifyColumns(const vector<vector<string_view>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                     MpcParserTWrapper &parser, size_t *numSkippedParses = nullptr,
+                     ClassificationEngine engine = CE_MPC, size_t cacheSize = 0,
+                     CacheKeyType cacheKeyType = CK_VALUE, InferenceStats *stats = nullptr,
+                     vector<ColumnSketch> *sketches = nullptr);
+
+/**
+ * Overload of `classifyColumns` for fields stored column by column. Each column is classified with a linear scan of its
+ * fields, which stops as soon as the column is classified as `FC_8_ARBITRY` (unless sketches are collected).
+ *
+ * @param fields Fields of at least one row, where row 0 contains the column names.
+ */
+void classifyColumns(const ColumnarFields &fields, vector<tuple<string, FieldCls>> &classifications,
+                     MpcParserTWrapper &parser, size_t *numSkippedParses = nullptr,
+                     ClassificationEngine engine = CE_MPC, size_t cacheSize = 0,
+                     CacheKeyType cacheKeyType = CK_VALUE, InferenceStats *stats = nullptr,
+                     vector<ColumnSketch> *sketches = nullptr);
+
+
+/**
+ * Multi-threaded version of `classifyColumns`.
+ *
+ * @note The rows (other than the header) are split into chunks that worker threads take from a shared queue. Each
+ *  worker classifies its chunks with its own parser object (leased from `MpcParserPool::global`) and the per-column
+ *  results of the workers are combined by taking the least restrictive classification of each column, so the result is
+ *  identical to that of `classifyColumns`.
+ *
+ * @param rows A vector where each element corresponds to a row of data. The first row is expected to contain the
+ *  column names. If there are no rows of data after it, no threads are started and every column is classified as
+ *  `FC_0_LOGICAL`; if there are no rows at all, no classifications are made.
+ * @param classifications A vector of tuples where each tuple contains as its first entry the column name and its second
+ *  entry the column classification.
+ * @param numThreads Number of worker threads to use. If 0, then the number of concurrent threads supported by the
+ *  hardware is used.
+ * @param engine The engine with which each string of data is classified.
+ */
+void classifyColumnsParallel(const vector<vector<string>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                             size_t numThreads = 0, ClassificationEngine engine = CE_MPC);
+
+/**
+ * Overload of `classifyColumnsParallel` for rows of fields that are views into a buffer.
+ */
+void classifyColumnsParallel(const vector<vector<string_view>> &rows, vector<tuple<string, FieldCls>> &classifications,
+                             size_t numThreads = 0, ClassificationEngine engine = CE_MPC);
+
+/**
+ * Memory-map a data file and split it into views of its lines (the reading phase of `classifyFile`).
+ *
+ * @param path Path of the data file
+ * @param file The object that maps the file, which must outlive the views
+ * @param lines Set to the views of the lines of the file
+ * @param stats If not null, the statistics to which those of the reading phase are added.
+ * @return 1 if the file was mapped and 0 if not.
+ */
+int mapFileLines(const string &path, MappedFile &file, vector<string_view> &lines, InferenceStats *stats = nullptr);
+
+/**
+ * Run delimiter detection, field splitting, and column classification over lines, as `classifyFile` does over the
+ * lines of a file.
+ *
+ * @param lines Views of the lines to classify
+ * @param delimRet Set to the value returned by `getDelim` for the lines
+ * @param classifications Set to the classification of each column, unless no rows were found
+ * @param parser An object containing the mpc parser with which each string of data is parsed.
+ * @param numRows If not null, set to the number of rows found, including the header row
+ * @param stats If not null, the statistics to which those of every phase of inference are added.
+ * @return 1 if rows were found and a consistent number of fields was found in every non-empty line, and 0 if not.
+ */
+int classifyLines(const vector<string_view> &lines, tuple<char, size_t> &delimRet,
+                  vector<tuple<string, FieldCls>> &classifications, MpcParserTWrapper &parser,
+                  size_t *numRows = nullptr, InferenceStats *stats = nullptr);
+
+/**
+ * Memory-map a data file and run delimiter detection, field splitting, and column classification over views of the
+ * mapped buffer (i.e., without copying each line or field into its own string).
+ *
+ * @param path Path of the data file
+ * @param delimRet Set to the value returned by `getDelim` for the file's lines
+ * @param classifications A vector of tuples where each tuple contains as its first entry the column name and its second
+ *  entry the column classification.
+ * @param parser An object containing the mpc parser with which each string of data is parsed.
+ * @param stats If not null, the statistics to which those of every phase of inference are added.
+ * @return 1 if the file was classified and a consistent number of fields was found in every non-empty line, and 0 if
+ *  the file could not be mapped, contained no data, or had an inconsistent number of fields.
+ */
+int classifyFile(const string &path, tuple<char, size_t> &delimRet, vector<tuple<string, FieldCls>> &classifications,
+                 MpcParserTWrapper &parser, InferenceStats *stats = nullptr);
+
+
+/**
+ * Version of `classifyFile` that first looks up the file's results in a schema cache, and stores them there if they
+ * were not found.
+ *
+ * @note A hit costs a `stat` of the file, the reads of its first and last blocks and its header line, and the read of
+ *  the cache entry, regardless of the size of the file. Statistics are only collected on a miss.
+ *
+ * @param cache The cache in which results are looked up and stored
+ * @param cacheHit If not null, set to whether the results were found in the cache
+ * @return The value that `classifyFile` returned for the file when its results were stored (or returns, on a miss).
+ */
+int classifyFileCached(const string &path, tuple<char, size_t> &delimRet,
+                       vector<tuple<string, FieldCls>> &classifications, MpcParserTWrapper &parser,
+                       const SchemaCache &cache, bool *cacheHit = nullptr, InferenceStats *stats = nullptr);
+
+
+/**
+ * Version of `classifyFile` that overlaps reading, tokenizing, and classifying the file by running them as a pipeline
+ * of threads, for files that are too large to map and split into lines before classifying them.
+ *
+ * @note The delimiter and header are first found with `detectDelimFromTail`. Then a reader thread reads the file in
+ *  blocks of `blockSize` bytes, a tokenizer thread splits them into lines and finds the bounds of the fields of each
+ *  data line (as `getFields` does), and `numClassifiers` classifier threads take turns folding batches of those lines
+ *  into their own classification of each column, which are combined at the end. Parsers are leased from
+ *  `MpcParserPool::global`.
+ * @note The stages are connected by bounded lock-free single-producer/single-consumer queues (one per classifier after
+ *  the tokenizer) of `queueCapacity` items, so a stage that gets ahead of the next one waits for it instead of
+ *  buffering the file in memory. How long each stage waited is reported in `stats`.
+ * @note The results are those of `classifyFile` whenever `detectDelimFromTail` finds the same header as `getDelim`
+ *  (see its notes).
+ *
+ * @param path Path of the data file
+ * @param delimRet Set to the delimiter and the index of the header line
+ * @param classifications Set to the classification of each column
+ * @param numClassifiers Number of classifier threads
+ * @param blockSize Number of bytes read at a time
+ * @param queueCapacity Maximum number of items in each queue between stages
+ * @param stats If not null, set to the statistics of each stage.
+ * @return 1 if the file was classified and a consistent number of fields was found in every non-empty line, and 0 if
+ *  the file could not be read, contained no data, or had an inconsistent number of fields.
+ */
+int classifyFilePipelined(const string &path, tuple<char, size_t> &delimRet,
+                          vector<tuple<string, FieldCls>> &classifications, size_t numClassifiers = 1,
+                          size_t blockSize = 1 << 20, size_t queueCapacity = 8, PipelineStats *stats = nullptr);
+
+
+/**
+ * State of the incremental classification of a file that is appended to (see `classifyFileIncremental`).
+ *
+ * @note Value-initialize a new state (`TailState state{};`), which makes the first call classify the whole file.
+ */
+struct TailState {
+    int established;  // 1 once a scan of the whole file found a delimiter and rows of data, and 0 before then
+    uint64_t device;  // Device and inode of the file, which change when the file is rotated
+    uint64_t inode;
+    size_t offset;  // Byte offset just past the last complete line that was classified
+    uint64_t prefixHash;  // Hash of the first bytes of the file (up to `offset`), which change if the file is replaced
+    char delim;
+    size_t headerLineIdx;  // Index of the header line as given by `getDelim`
+    int consistentFields;  // 1 if every non-empty line so far had the same number of fields and 0 if not
+    size_t numRows;  // Number of rows of data classified so far
+    vector<string> columnNames;
+    vector<FieldCls> fieldClasses;
+};
+
+
+/**
+ * Classify the lines appended to a file since the last call with the same state, and fold them into the state's
+ * column classifications, so that the cost of each call depends on the amount of new data rather than the size of the
+ * file.
+ *
+ * @note Only complete lines (those ending with a newline) are classified. A partial trailing line is left for a later
+ *  call, once the rest of it has been written.
+ * @note The whole file (up to its last newline) is classified as `classifyFile` would, and the state is reset, if the
+ *  state is new, no data was found by the previous scan, the file is shorter than the offset reached (it was
+ *  truncated), or its device, inode, or first bytes changed (it was rotated or replaced). A scan that finds no
+ *  delimiter or no rows of data (e.g., of a new file with only its header so far) leaves the state unestablished, and
+ *  the whole file is also classified again while fewer than 8 rows of data have been found, since a delimiter and
+ *  header found from so few rows may not hold.
+ * @note Once 8 rows have been found, the delimiter, header, and number of columns are kept for every appended line.
+ *  A later change of the file's format is not detected (other than by the status, if the number of fields changes);
+ *  classify the file with `classifyFile` (or start from a new state) if that can happen.
+ *
+ * @param path Path of the data file
+ * @param state The state of the previous call, which is updated
+ * @param classifications Set to the classification of each column given every line classified so far
+ * @param parser An object containing the mpc parser with which each string of data is parsed.
+ * @param fullScan If not null, set to whether the whole file was classified
+ * @param stats If not null, the statistics to which those of every phase of inference are added.
+ * @return 1 if the file was classified and a consistent number of fields was found in every non-empty line so far, and
+ *  0 if the file could not be read, contained no data, or had an inconsistent number of fields.
+ */
+int classifyFileIncremental(const string &path, TailState &state, vector<tuple<string, FieldCls>> &classifications,
+                            MpcParserTWrapper &parser, bool *fullScan = nullptr, InferenceStats *stats = nullptr);
+
+/**
+ * Save a state of `classifyFileIncremental`, e.g., for a monitor that runs as a new process for each poll. The state
+ * is written to a temporary file that is then renamed.
+ *
+ * @return 1 if the state was saved and 0 if not.
+ */
+int saveTailState(const TailState &state, const string &path);
+
+/**
+ * Load a state saved by `saveTailState`.
+ *
+ * @return 1 if the state was loaded and 0 if not (in which case `state` is unchanged).
+ */
+int loadTailState(const string &path, TailState &state);
+
+
+/**
+ * Classification of one column from a sample of its rows.
+ */
+struct SampledColumnCls {
+    string name;
+    FieldCls cls;  // Least restrictive classification of the column's sampled fields
+    size_t numSamples;  // Number of sampled rows (each of which has a field in this column)
+    size_t numSupporting;  // Number of sampled fields whose own classification is `cls`
+    double confidence;  // See `classifyFileSampled`
+};
+
+
+/**
+ * Result of `classifyFileSampled`.
+ */
+struct SampledInferenceResult {
+    char delim;
+    size_t headerOffset;  // Byte offset in the file of the line containing the column names
+    size_t numRejectedLines;  // Number of lines skipped while re-syncing because they had the wrong number of fields
+    int exhaustive;  // 1 if every data line was sampled (see `classifyFileSampled`) and 0 if not
+    vector<SampledColumnCls> columns;
+};
+
+
+/**
+ * Classify the columns of a data file from rows sampled at random byte offsets, for files too large to parse every
+ * row of.
+ *
+ * @note The delimiter and header are found with `detectDelimFromTail`. The bytes after the header are split into
+ *  `numSamples` strata of equal size and one offset is drawn uniformly from each stratum; the sample is the first line
+ *  that starts at or after the offset, so only the sampled lines (and the window read for the delimiter and header) are
+ *  paged in from the memory-mapped file. An offset may land within a quoted field that spans lines, so lines whose
+ *  number of fields differs from that of the header are skipped until one matches (at most 8 lines per stratum).
+ * @note If the file has at most `numSamples` data lines, then every data line is sampled instead, and the result is
+ *  that of a full scan (for files whose data lines all have as many fields as the header).
+ * @note The confidence of a column is 1 - (3 + s) / n, where n is the number of samples of the column and s is the
+ *  number of classifications that exactly one of its sampled fields has. 3 / n is the 95% "rule of three" bound: if no
+ *  sampled field needed a less restrictive classification than `cls`, then with 95% confidence fewer than 3 / n of the
+ *  file's rows do. s / n is the Good-Turing estimate of the chance that a further field has a classification that no
+ *  sampled field has, which is larger for columns whose classes (e.g., `cls` itself, when `numSupporting` is 1) were
+ *  only seen once, as rare classifications suggest that there are others that the sample missed. It is 1 for an
+ *  exhaustive sample and at least 0.
+ *
+ * @param path Path of the data file
+ * @param ret Set to the result
+ * @param parser An object containing the mpc parser with which each sampled field is parsed.
+ * @param numSamples Maximum number of rows to sample
+ * @param seed Seed of the random offsets, so that a sample can be reproduced
+ * @param engine The engine with which each sampled field is classified.
+ * @return 1 if the delimiter and header were found and at least one row was sampled, and 0 if not.
+ */
+int classifyFileSampled(const string &path, SampledInferenceResult &ret, MpcParserTWrapper &parser,
+                        size_t numSamples = 1000, uint64_t seed = 0, ClassificationEngine engine = CE_MPC);
+
+
+/**
+ * Classification of the rows of part of a data file, which can be merged with those of the other parts (in any order
+ * and grouping) to give the classification of the whole file (see `classifyByteRange`).
+ *
+ * @note Unlike `ColumnClassifier`, this doesn't need the header: every field of every row is classified, and the
+ *  column names (and number of columns) are only needed to get the final classifications.
+ */
+struct PartialClassification {
+    vector<FieldCls> fieldClasses;  // Classification of each column, for as many columns as the longest row has fields
+    size_t numRows;  // Number of non-empty lines classified
+    size_t minNumFields;  // Smallest and largest numbers of fields of those lines (-1 and 0 if there are none)
+    size_t maxNumFields;
+    vector<ColumnSketch> sketches;  // Sketch of each column (empty unless sketches were collected)
+
+    PartialClassification();
+
+    /**
+     * Fold the classification of other rows of the same file into this one.
+     *
+     * @note The partial classifications being merged should either all or none have sketches.
+     */
+    void merge(const PartialClassification &other);
+
+    /**
+     * @return 1 if every row had `numColumns` fields (or there were no rows) and 0 if not.
+     */
+    int isConsistent(size_t numColumns) const;
+
+    /**
+     * Append a tuple of each column name and its classification, ignoring the fields of rows that have more fields than
+     * there are column names (as `classifyColumns` does).
+     */
+    void getClassifications(const vector<string> &columnNames,
+                            vector<tuple<string, FieldCls>> &classifications) const;
+};
+
+
+/**
+ * Where the header and data of a data file are, for splitting its data into byte ranges (see `getShardLayout`).
+ */
+struct ShardLayout {
+    char delim;
+    size_t headerLineIdx;  // Index of the header line, as given by `getDelim`
+    size_t headerOffset;  // Byte offset of that line
+    size_t dataOffset;  // Byte offset of the line after the header, from which the ranges of data should start
+    size_t fileSize;
+    vector<string> columnNames;
+};
+
+
+/**
+ * Find the delimiter, header, and start of the data of a data file, which the coordinator of a sharded classification
+ * gives to the shards (or uses itself, for the column names).
+ *
+ * @note The delimiter and header are found with `detectDelimFromTail`.
+ *
+ * @return 1 if a header line was found and 0 if not.
+ */
+int getShardLayout(const string &path, ShardLayout &ret);
+
+
+/**
+ * Classify the rows of a data file that start within a range of bytes, e.g., in one of several processes that each
+ * take a range of a large file.
+ *
+ * @note A line belongs to the range that contains its first byte (and may run past the end of the range), so ranges
+ *  that split the data of a file at arbitrary offsets classify each line exactly once. Every non-empty line is taken
+ *  as a row of data, so the ranges should cover the data of the file from `ShardLayout::dataOffset`. Merging the
+ *  results of ranges that cover the data gives the classifications and consistency of `classifyFile`, whenever
+ *  `getShardLayout` finds the same header as `getDelim`.
+ *
+ * @param path Path of the data file
+ * @param delim The delimiter of the file
+ * @param begin Byte offset of the start of the range
+ * @param end Byte offset of the end of the range (exclusive)
+ * @param ret Set to the classification of the rows of the range
+ * @param parser An object containing the mpc parser with which each string of data is parsed.
+ * @param collectSketches Whether to collect the sketch of each column (see `ColumnSketch`)
+ * @return 1 if the file could be mapped and 0 if not.
+ */
+int classifyByteRange(const string &path, char delim, size_t begin, size_t end, PartialClassification &ret,
+                      MpcParserTWrapper &parser, bool collectSketches = false);
+
+/**
+ * Serialize a partial classification into a compact binary blob, e.g., for a shard to send to its coordinator. Blobs
+ * are in the byte order of the machine that wrote them.
+ */
+void serializePartialClassification(const PartialClassification &partial, string &ret);
+
+/**
+ * Deserialize a blob written by `serializePartialClassification`.
+ *
+ * @return 1 if the blob was valid and 0 if not (in which case `ret` is unchanged).
+ */
+int deserializePartialClassification(string_view blob, PartialClassification &ret);
+
+
+/**
+ * Result of inference on one file of a batch.
+ */
+struct FileInferenceResult {
+    string path;
+    int status;  // Value that `classifyFile` would return for the file
+    tuple<char, size_t> delim;  // Value returned by `getDelim` for the file's lines
+    vector<tuple<string, FieldCls>> classifications;
+};
+
+
+/**
+ * Run inference on many files in parallel, with the same results as calling `classifyFile` on each file.
+ *
+ * @note Files are scheduled over a `WorkStealingPool`. A file with more rows than `chunkRows` is split into chunks of
+ *  rows that are classified as separate tasks (which idle workers steal), so that one large file does not keep a
+ *  single worker busy while the others are idle. Parsers are leased from `MpcParserPool::global`.
+ *
+ * @param paths Paths of the data files
+ * @param results Set to the result for each file, in the same order as `paths`
+ * @param numThreads Number of worker threads to use. If 0, then the number of concurrent threads supported by the
+ *  hardware is used.
+ * @param chunkRows Maximum number of rows of a file that are classified by one task.
+ * @param cache If not null, a schema cache in which the results of each file are looked up before it is read (see
+ *  `classifyFileCached`) and stored after it is classified.
+ */
+void classifyFiles(const vector<string> &paths, vector<FileInferenceResult> &results, size_t numThreads = 0,
+                   size_t chunkRows = 65536, const SchemaCache *cache = nullptr);
+
+
+/**
+ * List the regular files in a directory (not including its subdirectories).
+ *
+ * @param directory Path of the directory
+ * @param ret Vector to which the path of each file is appended, in lexicographic order
+ * @return 1 if the directory could be listed and 0 if not.
+ */
+int listDataFiles(const string &directory, vector<string> &ret);
+
+
+/**
+ * Write the result of inference on a file as a single-line JSON object, e.g.:
+ *
+ *  {"path":"a.csv","status":1,"delimiter":",","header_line":0,"columns":[{"name":"x","class":"int"}]}
+ *
+ * where "header_line" is the index of the line containing the column names and "class" is the entry of
+ * `FieldClsCorrespondingNames` for the column's classification. The delimiter is null if it could not be inferred.
+ *
+ * @param result The result to write
+ * @param os Stream to which the object is written (without a trailing newline)
+ */
+void writeResultJson(const FileInferenceResult &result, ostream &os);
 
 
 #endif //TABULATED_DATA_INFERENCE_H
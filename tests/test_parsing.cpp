@@ -10,91 +10,93 @@
 #include <string>
 #include <vector>
 #include <tuple>
+#include <cstring>
 
 //#define GRAMMAR_DEBUG
 
 using namespace std;
 
 
-TEST(GRAMMAR, GrammarParsing) {
-    const vector<tuple<string, FieldCls>> grammar_test_targets{
-            {
-                    "0",                           FC_0_LOGICAL
-            },
-            {
-                    "1",                           FC_0_LOGICAL
-            },
-            {
-                    "0110",                        FC_1_BIT_STR
-            },
-            {  // %m-%d-%Y
-                    "04-02-2022",                  FC_4_DT_ONLY
-            },
-            {  // %d%m%y
-                    "181021",                      FC_4_DT_ONLY
-            },
-            {  // %m-%d-%y
-                    "04-02-22",                    FC_4_DT_ONLY
-            },
-            {  // %Y-%m-%d (ISO extended)
-                    "2022-04-02",                  FC_4_DT_ONLY
-            },
-            {  // %Y%m%d (ISO format, date only)
-                    "20220402",                    FC_4_DT_ONLY
-            },
-            {  // extra character over %m-%d-%Y
-                    "12-34-56789",                 FC_8_ARBITRY
-            },
-            {  // expect 12 hr time with PM
-                    "13-34-2022 PM",               FC_8_ARBITRY
-            },
-            {  // %H:%M:%S%F %p
-                    "10:03:22.0023 PM",            FC_3_TM_ONLY
-            },
-            {  // %H:%M:%S%F %p %ZP
-                    "13:03:22.0023 PM MST-07",     FC_3_TM_ONLY
-            },
-            {  // %H%M%S%F%q (ISO format, time only)
-                    "131211-0700",                 FC_3_TM_ONLY
-            },
-            {  // %Y-%b-%d %H:%M:%S%F %ZP (boost default input)
-                    "2005-Oct-15 13:12:11 MST-07", FC_2_DT_TIME
-            },
-            {  // %Y%m%dT%H%M%S%F%q (ISO format)
-                    "20051015T131211-0700",        FC_2_DT_TIME
-            },
-            {
-                    "2/9/2022 19:16",              FC_2_DT_TIME
-            },
-            {
-                    "2/9/2022 0:16",               FC_2_DT_TIME
-            },
-            {  // when faced with a string that can be either a date or time, choose date
-                    "120402",                      FC_4_DT_ONLY
-            },
-            {
-                    "12040",                       FC_5_INTEGER
-            },
-            {
-                    ".123",                        FC_6_FLT_DEC
-            },
-            {
-                    "0.123",                       FC_6_FLT_DEC
-            },
-            {
-                    "30.123",                      FC_6_FLT_DEC
-            },
-            {
-                    "4.63E-11",                    FC_7_FLT_EXP
-            },
-            {
-                    "-7e+02",                      FC_7_FLT_EXP
-            },
-            {
-                    "abcd123",                     FC_8_ARBITRY
-            }
-    };
+const vector<tuple<string, FieldCls>> grammar_test_targets{
+        {
+                "0",                           FC_0_LOGICAL
+        },
+        {
+                "1",                           FC_0_LOGICAL
+        },
+        {
+                "0110",                        FC_1_BIT_STR
+        },
+        {  // %m-%d-%Y
+                "04-02-2022",                  FC_4_DT_ONLY
+        },
+        {  // %d%m%y
+                "181021",                      FC_4_DT_ONLY
+        },
+        {  // %m-%d-%y
+                "04-02-22",                    FC_4_DT_ONLY
+        },
+        {  // %Y-%m-%d (ISO extended)
+                "2022-04-02",                  FC_4_DT_ONLY
+        },
+        {  // %Y%m%d (ISO format, date only)
+                "20220402",                    FC_4_DT_ONLY
+        },
+        {  // extra character over %m-%d-%Y
+                "12-34-56789",                 FC_8_ARBITRY
+        },
+        {  // expect 12 hr time with PM
+                "13-34-2022 PM",               FC_8_ARBITRY
+        },
+        {  // %H:%M:%S%F %p
+                "10:03:22.0023 PM",            FC_3_TM_ONLY
+        },
+        {  // %H:%M:%S%F %p %ZP
+                "13:03:22.0023 PM MST-07",     FC_3_TM_ONLY
+        },
+        {  // %H%M%S%F%q (ISO format, time only)
+                "131211-0700",                 FC_3_TM_ONLY
+        },
+        {  // %Y-%b-%d %H:%M:%S%F %ZP (boost default input)
+                "2005-Oct-15 13:12:11 MST-07", FC_2_DT_TIME
+        },
+        {  // %Y%m%dT%H%M%S%F%q (ISO format)
+                "20051015T131211-0700",        FC_2_DT_TIME
+        },
+        {
+                "2/9/2022 19:16",              FC_2_DT_TIME
+        },
+        {
+                "2/9/2022 0:16",               FC_2_DT_TIME
+        },
+        {  // when faced with a string that can be either a date or time, choose date
+                "120402",                      FC_4_DT_ONLY
+        },
+        {
+                "12040",                       FC_5_INTEGER
+        },
+        {
+                ".123",                        FC_6_FLT_DEC
+        },
+        {
+                "0.123",                       FC_6_FLT_DEC
+        },
+        {
+                "30.123",                      FC_6_FLT_DEC
+        },
+        {
+                "4.63E-11",                    FC_7_FLT_EXP
+        },
+        {
+                "-7e+02",                      FC_7_FLT_EXP
+        },
+        {
+                "abcd123",                     FC_8_ARBITRY
+        }
+};
+
 
+TEST(GRAMMAR, GrammarParsing) {
     auto parser = MpcParserTWrapper();
 
     mpc_result_t r;
@@ -137,3 +139,173 @@ TEST(GRAMMAR, GrammarParsing) {
         }
     }
 }
+
+
+TEST(GRAMMAR, FastPathMatchesGrammar) {
+    auto parser = MpcParserTWrapper();
+
+    // Besides the grammar test targets, check strings that are on the edges of the numeric and boolean rules
+    vector<string> fastPathTestTargets{
+            "00", "2", "-0", "-1", "+1", "-", ".", "1.", "-.5", "+.5", "1e5", "1E+05", ".5e3", "-7.25e-3", "1.e3",
+            "101010", "10101010", "123456", "1234567", "12345678", "123456789", "-123456", "1-2", "1.2.3", "0x1F", "",
+    };
+    for (const auto &target: grammar_test_targets) {
+        fastPathTestTargets.push_back(get<0>(target));
+    }
+
+    mpc_result_t r;
+    for (const auto &target: fastPathTestTargets) {
+        FieldCls fastRet;
+        if (!fastClassifyField(target.data(), target.size(), &fastRet)) { continue; }
+
+        int result = mpc_parse("input", target.c_str(), parser.getParserPtr(), &r);
+        auto grammarRet = extractFieldClsFromParser(&r, result);
+        if (fastRet != grammarRet) {
+            cout << "Fast path classification differs from grammar for '" << target << "'" << endl;
+        }
+        ASSERT_EQ(fastRet, grammarRet);
+    }
+
+    // Strings that may be dates or times are always left for the grammar
+    for (const auto &target: {"181021", "20220402", "131211-0700", "2/9/2022 19:16"}) {
+        FieldCls fastRet;
+        ASSERT_FALSE(fastClassifyField(target, strlen(target), &fastRet));
+    }
+}
+
+
+TEST(GRAMMAR, ColumnDispatchMatchesAll) {
+    auto parser = MpcParserTWrapper();
+
+    // Strings that fit more than one group (e.g., "101010" is a bit string and a date) as well as the test targets
+    vector<string> dispatchTestTargets{
+            "0", "101010", "10101010", "120402", "1e5", "1.5", "-3", "2022-04-02", "12:30", "abc", "",
+    };
+    for (const auto &target: grammar_test_targets) {
+        dispatchTestTargets.push_back(get<0>(target));
+    }
+
+    for (const auto &target: dispatchTestTargets) {
+        const FieldCls fieldRet = classifyField(target, parser);
+        for (int columnCls = 0; columnCls < NUM_FC; columnCls++) {
+            FieldClsCache cache(16);
+            InferenceStats stats;
+            auto ret = classifyFieldInColumn(target, (FieldCls) columnCls, parser, CE_MPC, &cache, &stats);
+            if (ret != std::max((FieldCls) columnCls, fieldRet)) {
+                cout << "Column dispatch differs from grammar for '" << target << "' in a column of class "
+                     << FieldClsCorrespondingNames[columnCls] << endl;
+            }
+            ASSERT_EQ(ret, std::max((FieldCls) columnCls, fieldRet));
+            ASSERT_LE(stats.numMpcParses, (size_t) NUM_GG);
+
+            // Only the field's own classification is cached
+            FieldCls cachedRet;
+            if (cache.lookup(target, &cachedRet)) {
+                ASSERT_EQ(cachedRet, fieldRet);
+            }
+        }
+    }
+}
+
+
+TEST(GRAMMAR, DfaMatchesGrammar) {
+    const GrammarDfa &dfa = GrammarDfa::get();
+    for (const auto &target: grammar_test_targets) {
+        const string &input_str = get<0>(target);
+        auto resultEnum = dfa.classify(input_str.data(), input_str.size());
+        if (resultEnum != get<1>(target)) {
+            cout << "Incorrect DFA classification for '" << input_str << "'" << endl;
+        }
+        ASSERT_EQ(resultEnum, get<1>(target));
+    }
+}
+
+
+TEST(GRAMMAR, DfaMatchesMpcParser) {
+    const GrammarDfa &dfa = GrammarDfa::get();
+    auto parser = MpcParserTWrapper();
+
+    // Besides the grammar test targets, check strings on the edges of the rules whose alternatives overlap (such as the
+    // `*_single_dig` rules, of which the automaton leaves out the alternatives that mpc can't reach)
+    vector<string> dfaTestTargets{
+            "1/2/22", "1/2/2022", "01/02/2022", "12/31/22", "13/31/22", "12/32/22", "1/32/22", "12-3-2022",
+            "Jan/2/2022", "Dec-31-22", "2022-1-2", "2022/12/31", "2022-Jan-02", "2022-13-02", "120402", "101010",
+            "1:30", "2:30", "9:30", "12:30", "13:30", "23:59", "24:00", "1:30 PM", "1:30PM", "12:30:15",
+            "12:30:15.25 AM", "10:03:22 +0700", "10:03:22-07:00", "1:30 PM MST-07", "1/2/22 1:30 PM",
+            "2022-04-02T10:03:22", "2022-04-02 24:00", "1.5e3", "-1.5E-3", "+1e5", ".5", "-0.25", "1.", "+1", "007",
+            "0101", "2", "-0", "",
+    };
+    for (const auto &target: grammar_test_targets) {
+        dfaTestTargets.push_back(get<0>(target));
+    }
+
+    mpc_result_t r;
+    for (const auto &target: dfaTestTargets) {
+        int result = mpc_parse("input", target.c_str(), parser.getParserPtr(), &r);
+        auto grammarRet = extractFieldClsFromParser(&r, result);
+        if (result) {
+            mpc_ast_delete((mpc_ast_t *) r.output);
+        } else {
+            mpc_err_delete(r.error);
+        }
+
+        auto dfaRet = dfa.classify(target.data(), target.size());
+        if (dfaRet != grammarRet) {
+            cout << "DFA classification differs from grammar for '" << target << "'" << endl;
+        }
+        ASSERT_EQ(dfaRet, grammarRet);
+    }
+}
+
+
+TEST(GRAMMAR, ShapeCacheMatchesGrammar) {
+    const GrammarDfa &dfa = GrammarDfa::get();
+    auto parser = MpcParserTWrapper();
+
+    // Group the bytes by their shape so that each byte of a target can be swapped for another of the same byte class
+    vector<vector<char>> byteClassMembers(dfa.getNumByteClasses());
+    for (int c = 1; c < 256; c++) {
+        string shape;
+        const char byte = (char) c;
+        dfa.getShape(&byte, 1, shape);
+        byteClassMembers.at((unsigned char) shape[0]).push_back(byte);
+    }
+
+    // Targets with the same shape are expected to have the same classification
+    for (const auto &target: grammar_test_targets) {
+        for (const auto &otherTarget: grammar_test_targets) {
+            string shape;
+            string otherShape;
+            dfa.getShape(get<0>(target).data(), get<0>(target).size(), shape);
+            dfa.getShape(get<0>(otherTarget).data(), get<0>(otherTarget).size(), otherShape);
+            if (shape == otherShape && get<1>(target) != get<1>(otherTarget)) {
+                cout << "'" << get<0>(target) << "' and '" << get<0>(otherTarget) << "' share a shape" << endl;
+            }
+            ASSERT_TRUE(shape != otherShape || get<1>(target) == get<1>(otherTarget));
+        }
+    }
+
+    // Classifying through a shape cache (whether the shape is new or cached) gives the grammar's classification, as
+    // does classifying variants of each target with bytes swapped for others of the same class
+    FieldClsCache cache(grammar_test_targets.size(), CK_SHAPE);
+    unsigned seed = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (const auto &target: grammar_test_targets) {
+            string variant = get<0>(target);
+            string byteShape;
+            for (auto &c: variant) {
+                dfa.getShape(&c, 1, byteShape);
+                const auto &members = byteClassMembers.at((unsigned char) byteShape[0]);
+                seed = seed * 1103515245 + 12345;
+                c = members.at((seed >> 8) % members.size());
+            }
+            for (const auto &input_str: {get<0>(target), variant}) {
+                auto resultEnum = classifyField(input_str, parser, CE_MPC, &cache);
+                if (resultEnum != get<1>(target)) {
+                    cout << "Incorrect shape-cached classification for '" << input_str << "'" << endl;
+                }
+                ASSERT_EQ(resultEnum, get<1>(target));
+            }
+        }
+    }
+}
@@ -5,6 +5,23 @@
  */
 
 #include <test_tabulated_data_inference.h>
+#include <delim_helpers.h>
+#include <tokenizer.h>
+#include <tail_window.h>
+#include <typed_columns.h>
+#include <spsc_queue.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 using namespace std;
 
@@ -76,3 +93,1093 @@ TEST_F(ClassificationTestFixture, ClassifiesFile) {
         }
     }
 }
+
+
+TEST_F(DelimTestFixture, FindsDelimAndLineIdxMappedFile) {
+    size_t targetIdx = -1;
+    for (const auto &target: fileTargets) {
+        targetIdx++;
+        MappedFile file;
+        ASSERT_TRUE(file.open(target));
+
+        vector<string_view> lines;
+        getBufferLines(file.view(), lines);
+        ASSERT_EQ(lines.size(), filesLines.at(targetIdx).size());
+
+        auto getDelimRet = getDelim(lines);
+        ASSERT_EQ(get<0>(getDelimRet), get<0>(findsDelimAndLineIdxExpectedValues.at(targetIdx)));
+        ASSERT_EQ(get<1>(getDelimRet), get<1>(findsDelimAndLineIdxExpectedValues.at(targetIdx)));
+    }
+}
+
+
+TEST_F(ClassificationTestFixture, ClassifiesMappedFile) {
+    size_t fileIdx = -1;
+    auto parser = MpcParserTWrapper();
+
+    for (const auto &target: fileTargets) {
+        fileIdx++;
+        tuple<char, size_t> delimRet;
+        vector<tuple<string, FieldCls>> classificationRet;
+        ASSERT_TRUE(classifyFile(target, delimRet, classificationRet, parser));
+
+        vector<tuple<string, string>> expectedClassificationsThisFile = classificationsExpected.at(fileIdx);
+        ASSERT_EQ(expectedClassificationsThisFile.size(), classificationRet.size());
+
+        size_t classificationIdx = -1;
+        for (const auto &classification: classificationRet) {
+            classificationIdx++;
+            ASSERT_STREQ(get<0>(expectedClassificationsThisFile.at(classificationIdx)).c_str(),
+                         get<0>(classification).c_str());
+            ASSERT_STREQ(get<1>(expectedClassificationsThisFile.at(classificationIdx)).c_str(),
+                         FieldClsCorrespondingNames[get<1>(classification)]);
+        }
+    }
+}
+
+
+TEST(InferenceStats, CollectsStatsOfEachPhase) {
+    auto parser = MpcParserTWrapper();
+    const string target = R"(tests/test_targets/xf-naca2408-il-50000.csv)";
+    vector<string> fileLines;
+    ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(target, fileLines));
+    size_t numBytes = 0;
+    for (const auto &line: fileLines) numBytes += line.size();
+
+    InferenceStats stats;
+    tuple<char, size_t> delimRet;
+    vector<tuple<string, FieldCls>> classificationRet;
+    ASSERT_TRUE(classifyFile(target, delimRet, classificationRet, parser, &stats));
+
+    ASSERT_EQ(stats.linesScanned[IP_READ], fileLines.size());
+    ASSERT_EQ(stats.bytesScanned[IP_READ], numBytes);
+    for (int phase = 0; phase < NUM_IP; phase++) {
+        ASSERT_GT(stats.phaseSeconds[phase], 0);
+    }
+
+    // The fields are read from the line given by getDelim (the header) to the end of the file
+    const size_t numDataLines = fileLines.size() - get<1>(delimRet);
+    ASSERT_EQ(stats.linesScanned[IP_FIELDS], numDataLines);
+    ASSERT_GE(stats.linesScanned[IP_DELIM], numDataLines);
+    ASSERT_GT(stats.peakFieldStorageBytes, numDataLines * sizeof(vector<string_view>));
+
+    // Every field but the header's is classified, and every mpc parse has a resulting classification
+    ASSERT_EQ(stats.numFieldsClassified, (numDataLines - 1) * classificationRet.size());
+    size_t numMpcParses = 0;
+    for (size_t numParses: stats.numMpcParsesByCls) numMpcParses += numParses;
+    ASSERT_EQ(stats.numMpcParses, numMpcParses);
+    ASSERT_LE(stats.numMpcParses, stats.numFieldsClassified);
+}
+
+
+TEST_F(ClassificationTestFixture, ClassifiesStreamedRows) {
+    size_t fileIdx = -1;
+    auto parser = MpcParserTWrapper();
+
+    for (const auto &thisFileLines: filesLines) {
+        fileIdx++;
+        auto delimRet = getDelim(thisFileLines);
+        vector<vector<string>> fieldRet;
+        ASSERT_TRUE(getFields(thisFileLines, get<0>(delimRet), fieldRet, get<1>(delimRet)));
+
+        // Feed the rows to the classifier one at a time, as if they were being received
+        ColumnClassifier classifier(fieldRet.at(0), parser);
+        for (size_t rowIdx = 1; rowIdx < fieldRet.size(); rowIdx++) {
+            ASSERT_TRUE(classifier.pushRow(fieldRet.at(rowIdx)));
+        }
+        ASSERT_EQ(classifier.getNumRows(), fieldRet.size() - 1);
+
+        vector<tuple<string, FieldCls>> classificationRet;
+        classifier.getClassifications(classificationRet);
+        vector<tuple<string, string>> expectedClassificationsThisFile = classificationsExpected.at(fileIdx);
+        ASSERT_EQ(expectedClassificationsThisFile.size(), classificationRet.size());
+
+        size_t classificationIdx = -1;
+        for (const auto &classification: classificationRet) {
+            classificationIdx++;
+            ASSERT_STREQ(get<0>(expectedClassificationsThisFile.at(classificationIdx)).c_str(),
+                         get<0>(classification).c_str());
+            ASSERT_STREQ(get<1>(expectedClassificationsThisFile.at(classificationIdx)).c_str(),
+                         FieldClsCorrespondingNames[get<1>(classification)]);
+        }
+    }
+}
+
+
+TEST(ClassifyColumns, SkipsSaturatedColumns) {
+    auto parser = MpcParserTWrapper();
+
+    // The first column is saturated by its first field, so only the second column's fields are parsed after that
+    const vector<vector<string>> partiallySaturatedRows{
+            {"name", "count"},
+            {"abc",  "1"},
+            {"def",  "12"},
+            {"ghi",  "123"},
+    };
+    vector<tuple<string, FieldCls>> classificationRet;
+    size_t numSkippedParses;
+    classifyColumns(partiallySaturatedRows, classificationRet, parser, &numSkippedParses);
+    ASSERT_EQ(get<1>(classificationRet.at(0)), FC_8_ARBITRY);
+    ASSERT_EQ(get<1>(classificationRet.at(1)), FC_5_INTEGER);
+    ASSERT_EQ(numSkippedParses, 2u);
+
+    // Once every column is saturated, the remaining rows are not read at all
+    const vector<vector<string>> saturatedRows{
+            {"name", "comment"},
+            {"abc",  "n/a"},
+            {"1",    "2"},
+            {"3",    "4"},
+    };
+    classificationRet.clear();
+    classifyColumns(saturatedRows, classificationRet, parser, &numSkippedParses);
+    ASSERT_EQ(get<1>(classificationRet.at(0)), FC_8_ARBITRY);
+    ASSERT_EQ(get<1>(classificationRet.at(1)), FC_8_ARBITRY);
+    ASSERT_EQ(numSkippedParses, 4u);
+}
+
+
+TEST_F(ClassificationTestFixture, EnginesAgreeOnEveryField) {
+    auto parser = MpcParserTWrapper();
+
+    for (const auto &thisFileLines: filesLines) {
+        auto delimRet = getDelim(thisFileLines);
+        vector<vector<string>> fieldRet;
+        ASSERT_TRUE(getFields(thisFileLines, get<0>(delimRet), fieldRet, get<1>(delimRet)));
+
+        for (size_t rowIdx = 1; rowIdx < fieldRet.size(); rowIdx++) {
+            for (const auto &field: fieldRet.at(rowIdx)) {
+                auto mpcRet = classifyField(field, parser, CE_MPC);
+                auto dfaRet = classifyField(field, parser, CE_DFA);
+                if (mpcRet != dfaRet) {
+                    cout << "Engines disagree on '" << field << "'" << endl;
+                }
+                ASSERT_EQ(mpcRet, dfaRet);
+            }
+        }
+
+        vector<tuple<string, FieldCls>> mpcClassificationRet;
+        vector<tuple<string, FieldCls>> dfaClassificationRet;
+        classifyColumns(fieldRet, mpcClassificationRet, parser, nullptr, CE_MPC);
+        classifyColumns(fieldRet, dfaClassificationRet, parser, nullptr, CE_DFA);
+        ASSERT_EQ(mpcClassificationRet, dfaClassificationRet);
+    }
+}
+
+
+TEST(ClassifyColumns, ParallelMatchesSerial) {
+    auto parser = MpcParserTWrapper();
+
+    // long_SEMS.dat has enough rows to be split into several chunks
+    for (const auto &target: {R"(tests/test_targets/long_SEMS.dat)", R"(tests/test_targets/acsm_shortened.csv)"}) {
+        vector<string> fileLines;
+        ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(target, fileLines));
+        auto delimRet = getDelim(fileLines);
+        vector<vector<string>> fieldRet;
+        ASSERT_TRUE(getFields(fileLines, get<0>(delimRet), fieldRet, get<1>(delimRet)));
+
+        vector<tuple<string, FieldCls>> serialClassificationRet;
+        classifyColumns(fieldRet, serialClassificationRet, parser);
+        for (size_t numThreads: {1, 2, 4}) {
+            vector<tuple<string, FieldCls>> parallelClassificationRet;
+            classifyColumnsParallel(fieldRet, parallelClassificationRet, numThreads);
+            ASSERT_EQ(serialClassificationRet, parallelClassificationRet);
+        }
+    }
+
+    // Without rows of data, the header columns are classified as with `classifyColumns`, and without rows at all no
+    // classifications are made
+    const vector<vector<string>> headerOnly{{"a", "b"}};
+    vector<tuple<string, FieldCls>> serialClassificationRet;
+    vector<tuple<string, FieldCls>> parallelClassificationRet;
+    classifyColumns(headerOnly, serialClassificationRet, parser);
+    classifyColumnsParallel(headerOnly, parallelClassificationRet, 4);
+    ASSERT_EQ(serialClassificationRet, parallelClassificationRet);
+    ASSERT_EQ(parallelClassificationRet.size(), 2u);
+    parallelClassificationRet.clear();
+    classifyColumnsParallel(vector<vector<string>>(), parallelClassificationRet, 4);
+    ASSERT_TRUE(parallelClassificationRet.empty());
+}
+
+
+TEST(FieldClsCache, CachesUpToMaxEntries) {
+    FieldClsCache cache(2);
+    FieldCls fieldCls;
+    ASSERT_FALSE(cache.lookup("16:02:53", &fieldCls));
+    cache.insert(string("16:02:53"), FC_3_TM_ONLY);
+    cache.insert("2018-10-21", FC_4_DT_ONLY);
+    cache.insert("n/a", FC_8_ARBITRY);  // Not cached, as the cache is full
+    ASSERT_EQ(cache.getNumEntries(), 2u);
+
+    ASSERT_TRUE(cache.lookup("16:02:53", &fieldCls));
+    ASSERT_EQ(fieldCls, FC_3_TM_ONLY);
+    ASSERT_TRUE(cache.lookup("2018-10-21", &fieldCls));
+    ASSERT_EQ(fieldCls, FC_4_DT_ONLY);
+    ASSERT_FALSE(cache.lookup("n/a", &fieldCls));
+    ASSERT_EQ(cache.getNumHits(), 2u);
+    ASSERT_EQ(cache.getNumMisses(), 2u);
+}
+
+
+TEST_F(ClassificationTestFixture, CachedClassificationMatchesUncached) {
+    auto parser = MpcParserTWrapper();
+
+    for (const auto &thisFileLines: filesLines) {
+        auto delimRet = getDelim(thisFileLines);
+        vector<vector<string>> fieldRet;
+        ASSERT_TRUE(getFields(thisFileLines, get<0>(delimRet), fieldRet, get<1>(delimRet)));
+
+        vector<tuple<string, FieldCls>> classificationRet;
+        vector<tuple<string, FieldCls>> cachedClassificationRet;
+        classifyColumns(fieldRet, classificationRet, parser);
+        classifyColumns(fieldRet, cachedClassificationRet, parser, nullptr, CE_MPC, 64);
+        ASSERT_EQ(classificationRet, cachedClassificationRet);
+    }
+
+    // Each distinct value that the fast path can't classify is parsed once
+    vector<vector<string>> rows{{"time"}};
+    for (int i = 0; i < 10; i++) {
+        rows.push_back({i % 2 ? "16:02:53" : "16:02:54"});
+    }
+    ColumnClassifier classifier(rows.at(0), parser);
+    classifier.enableCache(64);
+    classifier.pushRows(vector<vector<string>>(rows.begin() + 1, rows.end()));
+    ASSERT_EQ(classifier.getFieldClasses().at(0), FC_3_TM_ONLY);
+    ASSERT_EQ(classifier.getNumCacheMisses(), 2u);
+    ASSERT_EQ(classifier.getNumCacheHits(), 8u);
+}
+
+
+TEST(MpcParserPool, ReusesParsers) {
+    MpcParserPool pool;
+    {
+        auto lease = pool.acquire();
+        ASSERT_EQ(pool.getNumCompiled(), 1u);
+        ASSERT_EQ(pool.getNumIdle(), 0u);
+    }
+    ASSERT_EQ(pool.getNumIdle(), 1u);
+
+    // The idle parser is handed out again, and a second parser is only compiled while the first one is leased
+    {
+        auto firstLease = pool.acquire();
+        ASSERT_EQ(pool.getNumCompiled(), 1u);
+        auto secondLease = pool.acquire();
+        ASSERT_EQ(pool.getNumCompiled(), 2u);
+        ASSERT_NE(&firstLease.get(), &secondLease.get());
+    }
+    ASSERT_EQ(pool.getNumIdle(), 2u);
+
+    // Concurrent callers never compile more parsers than there are callers, and the parsers they lease classify the
+    // same as a parser of their own. The strings are parsed with mpc directly (the fast path would resolve the exponent
+    // floats and bit strings without the parser)
+    const vector<string> targets{
+            "2022-04-02", "04/02/2022", "20220402", "181021", "2022-04-02T10:30:00", "10:30 PM", "1.5e10", "-2E-3",
+            "3.0e+08", "010101", "11001010", "abc",
+    };
+    const auto parseWithMpc = [](const string &target, MpcParserTWrapper &parser) {
+        mpc_result_t r;
+        int result = mpc_parse("input", target.c_str(), parser.getParserPtr(), &r);
+        FieldCls ret = extractFieldClsFromParser(&r, result);
+        if (result) {
+            mpc_ast_delete((mpc_ast_t *) r.output);
+        } else {
+            mpc_err_delete(r.error);
+        }
+        return ret;
+    };
+    vector<FieldCls> expected;
+    {
+        MpcParserTWrapper parser;
+        for (const auto &target: targets) {
+            expected.push_back(parseWithMpc(target, parser));
+        }
+    }
+
+    const size_t numThreads = 4;
+    atomic<size_t> numMismatches(0);
+    mutex leasedMutex;
+    set<const MpcParserTWrapper *> leasedParsers;
+    vector<thread> threads;
+    for (size_t threadIdx = 0; threadIdx < numThreads; threadIdx++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 100; i++) {
+                auto lease = pool.acquire();
+                {
+                    lock_guard<mutex> lock(leasedMutex);
+                    leasedParsers.insert(&lease.get());
+                }
+                for (size_t targetIdx = 0; targetIdx < targets.size(); targetIdx++) {
+                    if (parseWithMpc(targets[targetIdx], lease.get()) != expected[targetIdx]) {
+                        numMismatches++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &thisThread: threads) {
+        thisThread.join();
+    }
+    ASSERT_EQ(numMismatches.load(), 0u);
+    ASSERT_LE(pool.getNumCompiled(), numThreads);
+    ASSERT_LE(leasedParsers.size(), pool.getNumCompiled());
+    ASSERT_EQ(pool.getNumIdle(), pool.getNumCompiled());
+}
+
+
+TEST(WorkStealingPool, RunsNestedTasks) {
+    atomic<size_t> numRun(0);
+    WorkStealingPool pool(4);
+    for (int i = 0; i < 16; i++) {
+        pool.submit([&pool, &numRun]() {
+            for (int j = 0; j < 16; j++) {
+                pool.submit([&numRun]() { numRun++; });
+            }
+            numRun++;
+        });
+    }
+    pool.wait();
+    ASSERT_EQ(numRun, 16u * 17u);
+}
+
+
+TEST_F(ClassificationTestFixture, BatchMatchesClassifyFile) {
+    auto parser = MpcParserTWrapper();
+
+    // Small chunks split long_SEMS.dat over many tasks
+    for (size_t chunkRows: {(size_t) 65536, (size_t) 16}) {
+        vector<FileInferenceResult> results;
+        classifyFiles(fileTargets, results, 4, chunkRows);
+        ASSERT_EQ(results.size(), fileTargets.size());
+
+        for (size_t fileIdx = 0; fileIdx < fileTargets.size(); fileIdx++) {
+            tuple<char, size_t> delimRet;
+            vector<tuple<string, FieldCls>> classificationRet;
+            int status = classifyFile(fileTargets.at(fileIdx), delimRet, classificationRet, parser);
+            ASSERT_EQ(results.at(fileIdx).path, fileTargets.at(fileIdx));
+            ASSERT_EQ(results.at(fileIdx).status, status);
+            ASSERT_EQ(results.at(fileIdx).delim, delimRet);
+            ASSERT_EQ(results.at(fileIdx).classifications, classificationRet);
+        }
+    }
+
+    vector<FileInferenceResult> results;
+    classifyFiles({"tests/test_targets/does_not_exist.csv"}, results);
+    ASSERT_EQ(results.at(0).status, 0);
+}
+
+
+TEST(BatchInference, WritesResultJson) {
+    FileInferenceResult result{"dir/\"quoted\".csv", 1, {'\t', 3}, {{"a\tb", FC_5_INTEGER}, {"c", FC_8_ARBITRY}}};
+    ostringstream os;
+    writeResultJson(result, os);
+    ASSERT_EQ(os.str(), R"({"path":"dir/\"quoted\".csv","status":1,"delimiter":"\t","header_line":3,)"
+                        R"("columns":[{"name":"a\tb","class":"int"},{"name":"c","class":"arbitrary"}]})");
+}
+
+
+TEST_F(DelimTestFixture, TailWindowMatchesGetDelim) {
+    for (size_t targetIdx = 0; targetIdx < fileTargets.size(); targetIdx++) {
+        const auto &lines = get<0>(findsDelimAndLineIdxTestValues.at(targetIdx));
+        const char expectedDelim = get<1>(findsDelimAndLineIdxTestValues.at(targetIdx));
+        const size_t expectedLineIdx = get<2>(findsDelimAndLineIdxTestValues.at(targetIdx));
+        size_t expectedOffset = 0;
+        size_t fileSize = 0;
+        for (size_t lineIdx = 0; lineIdx < lines.size(); lineIdx++) {
+            if (lineIdx == expectedLineIdx) expectedOffset = fileSize;
+            fileSize += lines.at(lineIdx).size() + 1;
+        }
+
+        // Unbounded sample: the same lines as getDelim are given to the state machine
+        TailDelimResult ret{};
+        ASSERT_EQ(detectDelimFromTail(fileTargets.at(targetIdx), ret, (size_t) -1, 4096), 1);
+        ASSERT_EQ(ret.delim, expectedDelim);
+        ASSERT_EQ(ret.headerOffset, expectedOffset);
+        ASSERT_EQ(ret.usedHeadScan, 0);
+
+        // Bounded sample with small blocks: the header is found by the forward scan
+        ASSERT_EQ(detectDelimFromTail(fileTargets.at(targetIdx), ret, 20, 64), 1);
+        ASSERT_EQ(ret.delim, expectedDelim);
+        ASSERT_EQ(ret.headerOffset, expectedOffset);
+        if (ret.usedHeadScan) {
+            ASSERT_LT(ret.bytesRead, fileSize);
+        }
+    }
+
+    TailDelimResult ret{};
+    ASSERT_EQ(detectDelimFromTail("tests/test_targets/does_not_exist.csv", ret), 0);
+}
+
+
+TEST(SampledInference, MatchesFullScan) {
+    const vector<string> fileTargets{
+            R"(tests/test_targets/shortened_SEMS.dat)",
+            R"(tests/test_targets/long_SEMS.dat)",
+            R"(tests/test_targets/acsm_shortened.csv)",
+            R"(tests/test_targets/xf-naca2408-il-50000.csv)",
+    };
+    auto parser = MpcParserTWrapper();
+    for (auto engine: {CE_DFA, CE_MPC}) {
+        for (size_t fileIdx = 0; fileIdx < fileTargets.size(); fileIdx++) {
+            vector<string> lines;
+            ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(fileTargets.at(fileIdx), lines));
+            auto delimRet = getDelim(lines);
+            vector<vector<string>> rows;
+            getFields(lines, get<0>(delimRet), rows, get<1>(delimRet));
+            vector<tuple<string, FieldCls>> expected;
+            classifyColumns(rows, expected, parser, nullptr, engine);
+
+            // A budget smaller than the number of rows of long_SEMS.dat samples it, and the others are scanned fully
+            SampledInferenceResult ret{};
+            ASSERT_EQ(classifyFileSampled(fileTargets.at(fileIdx), ret, parser, 200, 1, engine), 1);
+            ASSERT_EQ(ret.delim, get<0>(delimRet));
+            ASSERT_EQ(ret.exhaustive, rows.size() - 1 <= 200);
+            ASSERT_EQ(ret.columns.size(), expected.size());
+            for (size_t col = 0; col < expected.size(); col++) {
+                const auto &column = ret.columns.at(col);
+                ASSERT_EQ(column.name, get<0>(expected.at(col)));
+                ASSERT_EQ(column.cls, get<1>(expected.at(col)));
+                ASSERT_GT(column.numSupporting, 0u);
+                ASSERT_LE(column.numSupporting, column.numSamples);
+                ASSERT_LE(column.numSamples, 200u);
+                if (!ret.exhaustive) {
+                    ASSERT_GT(column.numSamples, 100u);
+                    // Columns whose class was only seen once are less certain than those of a single class
+                    const double ruleOfThree = 1.0 - 3.0 / (double) column.numSamples;
+                    ASSERT_LE(column.confidence, ruleOfThree);
+                    if (column.numSupporting == column.numSamples) {
+                        ASSERT_DOUBLE_EQ(column.confidence, ruleOfThree);
+                    }
+                    if (column.numSupporting == 1) {
+                        ASSERT_LT(column.confidence, ruleOfThree);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+TEST(TypedColumns, ParsesValues) {
+    int64_t intRet;
+    ASSERT_TRUE(parseInt64Field("-42", intRet));
+    ASSERT_EQ(intRet, -42);
+    ASSERT_FALSE(parseInt64Field("9223372036854775808", intRet));
+    ASSERT_FALSE(parseInt64Field("1.5", intRet));
+    ASSERT_FALSE(parseInt64Field("", intRet));
+
+    double doubleRet;
+    ASSERT_TRUE(parseDoubleField("+1.5e3", doubleRet));
+    ASSERT_DOUBLE_EQ(doubleRet, 1500);
+    ASSERT_TRUE(parseDoubleField("-.5", doubleRet));
+    ASSERT_DOUBLE_EQ(doubleRet, -0.5);
+    ASSERT_FALSE(parseDoubleField("1e", doubleRet));
+    ASSERT_FALSE(parseDoubleField("+-1", doubleRet));
+
+    const vector<tuple<string, int64_t>> epochNsTargets{
+            {"20220402",                   1648857600000000000},
+            {"181021",                     1634515200000000000},  // %d%m%y, as %m%d%y has no 18th month
+            {"2022-04-02T13:14:15.5-0700", 1648930455500000000},
+            {"2/9/2022 7:00 PM",           1644433200000000000},
+            {"2/10/2022 0:00",             1644451200000000000},
+            {"16:02:53",                   57773 * (int64_t) 1000000000},
+            {"12:30 AM",                   1800 * (int64_t) 1000000000},
+            {"12:30 PM MST-07",            (12 * 3600 + 1800 + 7 * 3600) * (int64_t) 1000000000},
+    };
+    for (const auto &target: epochNsTargets) {
+        int64_t epochNsRet;
+        ASSERT_TRUE(parseEpochNsField(get<0>(target), epochNsRet)) << get<0>(target);
+        ASSERT_EQ(epochNsRet, get<1>(target)) << get<0>(target);
+    }
+    for (const auto &target: {"02/30/2022", "13:00 PM", "2022-04-02 25:00", "12:30 AMX", ""}) {
+        int64_t epochNsRet;
+        ASSERT_FALSE(parseEpochNsField(target, epochNsRet)) << target;
+    }
+}
+
+
+TEST_F(ClassificationTestFixture, MaterializesColumns) {
+    auto parser = MpcParserTWrapper();
+    vector<string> lines;
+    ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(R"(tests/test_targets/acsm_shortened.csv)", lines));
+    auto delimRet = getDelim(lines);
+    ColumnarFields fields;
+    getFields(lines, get<0>(delimRet), fields, get<1>(delimRet));
+    vector<tuple<string, FieldCls>> classifications;
+    classifyColumns(fields, classifications, parser, nullptr, CE_DFA);
+
+    vector<TypedColumn> columns;
+    ASSERT_EQ(materializeColumns(fields, classifications, columns), 1);
+    ASSERT_EQ(columns.size(), classifications.size());
+    for (const auto &column: columns) {
+        ASSERT_EQ(column.isValid.size(), fields.getNumRows() - 1);
+        ASSERT_EQ(column.numFailures, 0u);
+    }
+    ASSERT_EQ(columns.at(0).type, MT_DOUBLE);
+    ASSERT_DOUBLE_EQ(columns.at(0).doubleValues.at(0), 3.07175);
+    ASSERT_EQ(columns.at(5).type, MT_UINT8);
+    ASSERT_EQ(columns.at(5).uint8Values.at(0), 0);
+    ASSERT_EQ(columns.at(7).type, MT_DOUBLE);
+    ASSERT_DOUBLE_EQ(columns.at(7).doubleValues.at(0), 4.63E-11);
+    ASSERT_EQ(columns.at(15).type, MT_EPOCH_NS);
+    ASSERT_EQ(columns.at(15).int64Values.at(0), 1644433200000000000);
+
+    // Row-based fields give the same values, and fields that don't fit their column's type are reported
+    vector<vector<string>> rows;
+    getFields(lines, get<0>(delimRet), rows, get<1>(delimRet));
+    rows.at(2).at(0) = "not a number";
+    rows.at(3).pop_back();
+    ASSERT_EQ(materializeColumns(rows, classifications, columns), 0);
+    ASSERT_EQ(columns.at(0).numFailures, 1u);
+    ASSERT_EQ(columns.at(0).firstFailureRow, 1u);
+    ASSERT_EQ(columns.at(0).isValid.at(1), 0);
+    ASSERT_EQ(columns.back().numFailures, 1u);
+    ASSERT_EQ(columns.back().firstFailureRow, 2u);
+    ASSERT_EQ(columns.at(15).int64Values.at(0), 1644433200000000000);
+
+    classifications.pop_back();
+    ASSERT_EQ(materializeColumns(rows, classifications, columns), -1);
+    ASSERT_TRUE(columns.empty());
+}
+
+
+TEST(SchemaCache, ReusesResultsOfUnchangedFiles) {
+    const auto tmpDir = filesystem::temp_directory_path() / ("schema_cache_test_" + to_string(getpid()));
+    filesystem::remove_all(tmpDir);
+    filesystem::create_directories(tmpDir);
+    const string path = (tmpDir / "long_SEMS.dat").string();
+    filesystem::copy_file("tests/test_targets/long_SEMS.dat", path);
+    SchemaCache cache((tmpDir / "cache").string());
+
+    auto parser = MpcParserTWrapper();
+    tuple<char, size_t> expectedDelim;
+    vector<tuple<string, FieldCls>> expectedClassifications;
+    int expectedStatus = classifyFile(path, expectedDelim, expectedClassifications, parser);
+
+    for (bool expectedHit: {false, true}) {
+        tuple<char, size_t> delimRet;
+        vector<tuple<string, FieldCls>> classifications;
+        bool hit;
+        ASSERT_EQ(classifyFileCached(path, delimRet, classifications, parser, cache, &hit), expectedStatus);
+        ASSERT_EQ(hit, expectedHit);
+        ASSERT_EQ(delimRet, expectedDelim);
+        ASSERT_EQ(classifications, expectedClassifications);
+    }
+
+    // The batch interface shares the cache
+    vector<FileInferenceResult> results;
+    classifyFiles({path}, results, 2, 65536, &cache);
+    ASSERT_EQ(results.at(0).status, expectedStatus);
+    ASSERT_EQ(results.at(0).classifications, expectedClassifications);
+
+    // A change to the header line that keeps the size, modification time, and first and last blocks is caught by the
+    // hash of the header line
+    FileFingerprint fingerprint{};
+    ASSERT_TRUE(getFileFingerprint(path, fingerprint, 16));
+    vector<string> lines;
+    ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(path, lines));
+    size_t headerOffset = 0;
+    for (size_t lineIdx = 0; lineIdx < get<1>(expectedDelim); lineIdx++) {
+        headerOffset += lines.at(lineIdx).size() + 1;
+    }
+    const string &headerLine = lines.at(get<1>(expectedDelim));
+    ASSERT_TRUE(cache.store(fingerprint, headerOffset, headerLine, expectedStatus, expectedDelim,
+                            expectedClassifications));
+    int status;
+    tuple<char, size_t> delimRet;
+    vector<tuple<string, FieldCls>> classifications;
+    ASSERT_TRUE(cache.lookup(path, fingerprint, status, delimRet, classifications));
+
+    // Corrupt column and name lengths are misses rather than huge allocations (the number of columns follows the
+    // fixed-size fields of an entry, and the length of the first name follows it)
+    const size_t numColumnsOffset = 8 + 3 * 8 + 3 * 8 + 4 + 1 + 8;
+    for (const auto &[patchOffset, patchValue]: {make_pair(numColumnsOffset, 0xffffffffu),
+                                                 make_pair(numColumnsOffset + 4, 0xfffffff0u)}) {
+        for (const auto &entryPath: filesystem::directory_iterator(cache.getDirectory())) {
+            fstream entry(entryPath.path(), ios::in | ios::out | ios::binary);
+            entry.seekp((streamoff) patchOffset);
+            entry.write((const char *) &patchValue, sizeof(patchValue));
+        }
+        ASSERT_FALSE(cache.lookup(path, fingerprint, status, delimRet, classifications));
+        ASSERT_TRUE(cache.store(fingerprint, headerOffset, headerLine, expectedStatus, expectedDelim,
+                                expectedClassifications));
+    }
+    ASSERT_TRUE(cache.lookup(path, fingerprint, status, delimRet, classifications));
+
+    struct stat fileStat{};
+    ASSERT_EQ(stat(path.c_str(), &fileStat), 0);
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekp((streamoff) headerOffset);
+        file.put('X');
+    }
+    const timespec times[2]{fileStat.st_atim, fileStat.st_mtim};
+    ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+    FileFingerprint changedFingerprint{};
+    ASSERT_TRUE(getFileFingerprint(path, changedFingerprint, 16));
+    ASSERT_EQ(changedFingerprint.blocksHash, fingerprint.blocksHash);
+    ASSERT_EQ(changedFingerprint.mtimeNs, fingerprint.mtimeNs);
+    ASSERT_FALSE(cache.lookup(path, changedFingerprint, status, delimRet, classifications));
+
+    // Appending to the file changes its fingerprint
+    {
+        ofstream file(path, ios::app);
+        file << lines.back() << '\n';
+    }
+    bool hit;
+    classifyFileCached(path, delimRet, classifications, parser, cache, &hit);
+    ASSERT_FALSE(hit);
+
+    filesystem::remove_all(tmpDir);
+}
+
+
+TEST(IncrementalInference, ClassifiesAppendedLines) {
+    const auto tmpDir = filesystem::temp_directory_path() / ("incremental_test_" + to_string(getpid()));
+    filesystem::remove_all(tmpDir);
+    filesystem::create_directories(tmpDir);
+    const string path = (tmpDir / "acsm.csv").string();
+    const string referencePath = (tmpDir / "reference.csv").string();
+    vector<string> lines;
+    ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(R"(tests/test_targets/acsm_shortened.csv)", lines));
+
+    auto parser = MpcParserTWrapper();
+    auto writeLines = [&lines](const string &target, size_t numLines, const string &suffix) {
+        ofstream file(target, ios::trunc);
+        for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            file << lines.at(lineIdx) << '\n';
+        }
+        file << suffix;
+    };
+    auto expectMatchesClassifyFile = [&](size_t numLines, const vector<tuple<string, FieldCls>> &classifications) {
+        writeLines(referencePath, numLines, "");
+        tuple<char, size_t> delimRet;
+        vector<tuple<string, FieldCls>> expected;
+        ASSERT_EQ(classifyFile(referencePath, delimRet, expected, parser), 1);
+        ASSERT_EQ(classifications, expected);
+    };
+
+    vector<tuple<string, FieldCls>> classifications;
+    bool fullScan;
+
+    // A new file with only its header so far is not established, so appending data lines to it rescans it in full
+    const string newPath = (tmpDir / "new.csv").string();
+    TailState newState{};
+    writeLines(newPath, 1, "");
+    ASSERT_EQ(classifyFileIncremental(newPath, newState, classifications, parser, &fullScan), 0);
+    ASSERT_TRUE(fullScan);
+    ASSERT_FALSE(newState.established);
+    ASSERT_TRUE(classifications.empty());
+    {
+        ofstream file(newPath, ios::app);
+        for (size_t lineIdx = 1; lineIdx < lines.size(); lineIdx++) {
+            file << lines.at(lineIdx) << '\n';
+        }
+    }
+    ASSERT_EQ(classifyFileIncremental(newPath, newState, classifications, parser, &fullScan), 1);
+    ASSERT_TRUE(fullScan);
+    ASSERT_EQ(newState.delim, ',');
+    ASSERT_EQ(classifications.size(), newState.columnNames.size());
+    ASSERT_GT(classifications.size(), 1u);
+    expectMatchesClassifyFile(lines.size(), classifications);
+
+    // The partial trailing line is left for a later call, and a state with few rows is rescanned until it has enough
+    TailState state{};
+    writeLines(path, 5, lines.at(5).substr(0, 4));
+    ASSERT_EQ(classifyFileIncremental(path, state, classifications, parser, &fullScan), 1);
+    ASSERT_TRUE(fullScan);
+    ASSERT_EQ(state.numRows, 4u);
+    expectMatchesClassifyFile(5, classifications);
+    writeLines(path, 10, lines.at(10).substr(0, 4));
+    ASSERT_EQ(classifyFileIncremental(path, state, classifications, parser, &fullScan), 1);
+    ASSERT_TRUE(fullScan);
+    ASSERT_EQ(state.numRows, 9u);
+    expectMatchesClassifyFile(10, classifications);
+
+    // Completing the line and appending more only classifies the new lines, including after a save and load
+    const size_t prevOffset = state.offset;
+    writeLines(path, lines.size(), "");
+    const string statePath = (tmpDir / "state.bin").string();
+    ASSERT_TRUE(saveTailState(state, statePath));
+    TailState loadedState{};
+    ASSERT_TRUE(loadTailState(statePath, loadedState));
+    ASSERT_EQ(loadedState.offset, prevOffset);
+
+    // A corrupt number of columns or name length fails to load instead of allocating (the number of columns follows
+    // the fixed-size fields of the state, and the length of the first name follows it)
+    const size_t numColumnsOffset = 8 + 4 + 8 + 8 + 8 + 8 + 1 + 8 + 4 + 8;
+    for (const auto &[patchOffset, patchValue]: {make_pair(numColumnsOffset, 0xffffffffu),
+                                                 make_pair(numColumnsOffset + 4, 0xfffffff0u)}) {
+        const string corruptPath = statePath + ".corrupt";
+        filesystem::copy_file(statePath, corruptPath, filesystem::copy_options::overwrite_existing);
+        {
+            fstream corrupt(corruptPath, ios::in | ios::out | ios::binary);
+            corrupt.seekp((streamoff) patchOffset);
+            corrupt.write((const char *) &patchValue, sizeof(patchValue));
+        }
+        TailState corruptState{};
+        ASSERT_FALSE(loadTailState(corruptPath, corruptState));
+    }
+    ASSERT_EQ(classifyFileIncremental(path, loadedState, classifications, parser, &fullScan), 1);
+    ASSERT_FALSE(fullScan);
+    ASSERT_EQ(loadedState.numRows, lines.size() - 1);
+    expectMatchesClassifyFile(lines.size(), classifications);
+
+    // Nothing new
+    ASSERT_EQ(classifyFileIncremental(path, loadedState, classifications, parser, &fullScan), 1);
+    ASSERT_FALSE(fullScan);
+    ASSERT_EQ(loadedState.numRows, lines.size() - 1);
+
+    // Truncation and rotation (a new file moved into place) are rescanned in full
+    writeLines(path, 8, "");
+    ASSERT_EQ(classifyFileIncremental(path, loadedState, classifications, parser, &fullScan), 1);
+    ASSERT_TRUE(fullScan);
+    ASSERT_EQ(loadedState.numRows, 7u);
+
+    const string rotatedPath = (tmpDir / "acsm.csv.1").string();
+    filesystem::rename(path, rotatedPath);
+    writeLines(referencePath, 8, "");
+    filesystem::copy_file(referencePath, path);
+    ASSERT_EQ(classifyFileIncremental(path, loadedState, classifications, parser, &fullScan), 1);
+    ASSERT_TRUE(fullScan);
+    ASSERT_EQ(loadedState.numRows, 7u);
+
+    filesystem::remove_all(tmpDir);
+}
+
+
+TEST_F(ClassificationTestFixture, ShardedMatchesClassifyFile) {
+    auto parser = MpcParserTWrapper();
+    for (const auto &target: fileTargets) {
+        tuple<char, size_t> expectedDelimRet;
+        vector<tuple<string, FieldCls>> expected;
+        const int expectedStatus = classifyFile(target, expectedDelimRet, expected, parser);
+
+        ShardLayout layout;
+        ASSERT_EQ(getShardLayout(target, layout), 1) << target;
+        ASSERT_EQ(make_tuple(layout.delim, layout.headerLineIdx), expectedDelimRet) << target;
+
+        PartialClassification whole;
+        ASSERT_EQ(classifyByteRange(target, layout.delim, layout.dataOffset, layout.fileSize, whole, parser, true), 1);
+
+        // Shard boundaries fall within lines; the shards are merged through blobs in two different orders
+        for (size_t numShards: {(size_t) 2, (size_t) 3, (size_t) 7, (size_t) 64}) {
+            vector<PartialClassification> shards(numShards);
+            for (size_t shardIdx = 0; shardIdx < numShards; shardIdx++) {
+                const size_t dataSize = layout.fileSize - layout.dataOffset;
+                PartialClassification shard;
+                ASSERT_EQ(classifyByteRange(target, layout.delim, layout.dataOffset + dataSize * shardIdx / numShards,
+                                            layout.dataOffset + dataSize * (shardIdx + 1) / numShards, shard, parser,
+                                            true), 1);
+                string blob;
+                serializePartialClassification(shard, blob);
+                ASSERT_EQ(deserializePartialClassification(blob, shards[shardIdx]), 1);
+            }
+            PartialClassification forward, backward;
+            for (size_t shardIdx = 0; shardIdx < numShards; shardIdx++) {
+                forward.merge(shards[shardIdx]);
+                PartialClassification prefix = shards[numShards - 1 - shardIdx];
+                prefix.merge(backward);
+                backward = std::move(prefix);
+            }
+
+            for (const auto *merged: {&forward, &backward}) {
+                vector<tuple<string, FieldCls>> classifications;
+                merged->getClassifications(layout.columnNames, classifications);
+                ASSERT_EQ(classifications, expected) << target << ", " << numShards << " shards";
+                ASSERT_EQ(merged->isConsistent(layout.columnNames.size()), expectedStatus);
+                ASSERT_EQ(merged->numRows, whole.numRows);
+                ASSERT_EQ(merged->sketches.size(), whole.sketches.size());
+                for (size_t columnIdx = 0; columnIdx < whole.sketches.size(); columnIdx++) {
+                    ASSERT_EQ(merged->sketches[columnIdx].numFields, whole.sketches[columnIdx].numFields);
+                    ASSERT_EQ(merged->sketches[columnIdx].hllRegisters, whole.sketches[columnIdx].hllRegisters);
+                }
+            }
+        }
+    }
+
+    PartialClassification partial;
+    ASSERT_EQ(deserializePartialClassification("not a blob", partial), 0);
+    partial.fieldClasses.assign(3, FC_5_INTEGER);
+    partial.sketches.resize(3);
+    string blob;
+    serializePartialClassification(partial, blob);
+    ASSERT_EQ(deserializePartialClassification(blob.substr(0, blob.size() - 1), partial), 0);
+    ASSERT_EQ(deserializePartialClassification(blob, partial), 1);
+    ASSERT_EQ(partial.sketches.size(), 3u);
+}
+
+
+TEST(ColumnSketch, CollectsStatistics) {
+    ColumnSketch sketch;
+    for (const string field: {"3", "-12", "", "NA", "4.5e2", "abc", "null", "3", ""}) {
+        sketch.add(field);
+    }
+    ASSERT_EQ(sketch.numFields, 9u);
+    ASSERT_EQ(sketch.numEmpty, 2u);
+    ASSERT_EQ(sketch.numNull, 2u);
+    ASSERT_EQ(sketch.numInt64, 3u);
+    ASSERT_EQ(sketch.minInt64, -12);
+    ASSERT_EQ(sketch.maxInt64, 3);
+    ASSERT_EQ(sketch.numDouble, 4u);
+    ASSERT_DOUBLE_EQ(sketch.minDouble, -12);
+    ASSERT_DOUBLE_EQ(sketch.maxDouble, 450);
+    ASSERT_NEAR(sketch.getDistinctEstimate(), 7, 0.5);
+
+    // Merging the sketches of two halves gives the sketch of the whole (up to 6 standard errors of the estimate)
+    ColumnSketch evenSketch, oddSketch, wholeSketch;
+    const size_t numValues = 200000;
+    for (size_t i = 0; i < numValues; i++) {
+        const string field = to_string(i % (numValues / 2));
+        (i % 2 ? oddSketch : evenSketch).add(field);
+        wholeSketch.add(field);
+    }
+    evenSketch.merge(oddSketch);
+    ASSERT_EQ(evenSketch.hllRegisters, wholeSketch.hllRegisters);
+    ASSERT_EQ(evenSketch.numInt64, numValues);
+    ASSERT_EQ(evenSketch.maxInt64, (int64_t) numValues / 2 - 1);
+    ASSERT_NEAR(evenSketch.getDistinctEstimate(), numValues / 2.0, numValues / 2.0 * 6 * 1.04 / 32);
+}
+
+
+TEST(ClassifyColumns, CollectsSketchesInSamePass) {
+    const vector<string> lines{"a,b,c", "1,x,", "2,y,NA", "30,z,", "4,x,2.5"};
+    vector<vector<string>> rows;
+    ColumnarFields columnarFields;
+    getFields(lines, ',', rows);
+    getFields(lines, ',', columnarFields);
+
+    auto parser = MpcParserTWrapper();
+    for (ClassificationEngine engine: {CE_MPC, CE_DFA}) {
+        vector<tuple<string, FieldCls>> expected, classifications, columnarClassifications;
+        vector<ColumnSketch> sketches, columnarSketches;
+        classifyColumns(rows, expected, parser, nullptr, engine);
+        classifyColumns(rows, classifications, parser, nullptr, engine, 0, CK_VALUE, nullptr, &sketches);
+        classifyColumns(columnarFields, columnarClassifications, parser, nullptr, engine, 0, CK_VALUE, nullptr,
+                        &columnarSketches);
+        ASSERT_EQ(classifications, expected);
+        ASSERT_EQ(columnarClassifications, expected);
+
+        ASSERT_EQ(sketches.size(), 3u);
+        ASSERT_EQ(sketches[0].numInt64, 4u);
+        ASSERT_EQ(sketches[0].minInt64, 1);
+        ASSERT_EQ(sketches[0].maxInt64, 30);
+        ASSERT_EQ(sketches[1].numFields, 4u);
+        ASSERT_NEAR(sketches[1].getDistinctEstimate(), 3, 0.5);
+        ASSERT_EQ(sketches[2].numEmpty, 2u);
+        ASSERT_EQ(sketches[2].numNull, 1u);
+        ASSERT_DOUBLE_EQ(sketches[2].maxDouble, 2.5);
+        for (size_t columnIdx = 0; columnIdx < sketches.size(); columnIdx++) {
+            ASSERT_EQ(columnarSketches[columnIdx].numFields, sketches[columnIdx].numFields);
+            ASSERT_EQ(columnarSketches[columnIdx].hllRegisters, sketches[columnIdx].hllRegisters);
+        }
+    }
+
+    // Saturated columns are still sketched
+    const vector<vector<string>> saturatedRows{{"a"}, {"x y"}, {"1"}, {""}};
+    vector<tuple<string, FieldCls>> classifications;
+    vector<ColumnSketch> sketches;
+    classifyColumns(saturatedRows, classifications, parser, nullptr, CE_DFA, 0, CK_VALUE, nullptr, &sketches);
+    ASSERT_EQ(sketches.at(0).numFields, 3u);
+    ASSERT_EQ(sketches.at(0).numEmpty, 1u);
+}
+
+
+TEST(SpscQueue, PassesItemsInOrder) {
+    SpscQueue<size_t> queue(3);
+    ASSERT_EQ(queue.getCapacity(), 4u);
+    size_t item;
+    ASSERT_FALSE(queue.tryPop(item));
+
+    // The small capacity makes the producer wait for the consumer
+    const size_t numItems = 100000;
+    double stallSeconds = 0;
+    thread producer([&queue, &stallSeconds]() {
+        for (size_t i = 0; i < numItems; i++) {
+            queue.push(size_t(i), &stallSeconds);
+        }
+    });
+    for (size_t i = 0; i < numItems; i++) {
+        queue.pop(item);
+        ASSERT_EQ(item, i);
+    }
+    producer.join();
+    ASSERT_FALSE(queue.tryPop(item));
+    ASSERT_GE(stallSeconds, 0);
+}
+
+
+TEST_F(ClassificationTestFixture, PipelineMatchesClassifyFile) {
+    auto parser = MpcParserTWrapper();
+
+    // Tiny blocks split most lines across blocks, and tiny queues make every stage wait on the others
+    for (size_t blockSize: {(size_t) 7, (size_t) 4096, (size_t) 1 << 20}) {
+        for (size_t numClassifiers: {(size_t) 1, (size_t) 3}) {
+            for (const auto &target: fileTargets) {
+                tuple<char, size_t> expectedDelimRet, delimRet;
+                vector<tuple<string, FieldCls>> expected, classifications;
+                const int expectedStatus = classifyFile(target, expectedDelimRet, expected, parser);
+                PipelineStats stats;
+                const int status = classifyFilePipelined(target, delimRet, classifications, numClassifiers, blockSize,
+                                                         2, &stats);
+                ASSERT_EQ(status, expectedStatus) << target;
+                ASSERT_EQ(delimRet, expectedDelimRet) << target;
+                ASSERT_EQ(classifications, expected) << target;
+
+                ASSERT_EQ(stats.stages.size(), 2 + numClassifiers);
+                ASSERT_EQ(stats.stages[0].numBytes, filesystem::file_size(target));
+                size_t numBatchBytes = 0;
+                for (size_t stageIdx = 2; stageIdx < stats.stages.size(); stageIdx++) {
+                    numBatchBytes += stats.stages[stageIdx].numBytes;
+                }
+                ASSERT_EQ(numBatchBytes, stats.stages[1].numBytes);
+            }
+        }
+    }
+
+    tuple<char, size_t> delimRet;
+    vector<tuple<string, FieldCls>> classifications;
+    ASSERT_EQ(classifyFilePipelined("tests/test_targets/does_not_exist.csv", delimRet, classifications), 0);
+}
+
+
+TEST(DelimHelpers, VectorizedCountMatchesScalar) {
+    // Lengths straddle the 16- and 32-byte block sizes and the point at which the 8-bit counters are flushed
+    mt19937 generator(0);
+    const char alphabet[]{',', ';', ' ', '\t', 'a', '0', '.'};
+    for (size_t len: {0, 1, 15, 16, 17, 31, 32, 33, 100, 4095, 4096, 8161, 20000}) {
+        string str(len, '\0');
+        for (auto &c: str) c = alphabet[generator() % sizeof(alphabet)];
+        string allDelims(len, '\t');
+
+        for (const auto &target: {str, allDelims}) {
+            size_t scalarCount[NDELIMS] = {0};
+            size_t vectorizedCount[NDELIMS] = {0};
+            countDelimsScalar(target.data(), target.size(), scalarCount);
+            countDelims(target.data(), target.size(), vectorizedCount);
+            for (size_t i = 0; i < NDELIMS; i++) {
+                ASSERT_EQ(scalarCount[i], vectorizedCount[i]);
+            }
+        }
+    }
+}
+
+
+TEST(Tokenizer, SplitsQuotedFields) {
+    // The long record places quotes, delimiters within quotes, and escaped quotes on either side of 64-byte boundaries
+    const string longQuoted = "\"" + string(60, 'a') + ",\"\"" + string(10, 'b') + "\"";
+    const vector<tuple<string, vector<string>>> targets{
+            {"a,b,c",                              {"a", "b", "c"}},
+            {"",                                   {""}},
+            {",,",                                 {"", "", ""}},
+            {"\"a,b\",c",                          {"a,b", "c"}},
+            {"\"say \"\"hi\"\"\",2",               {"say \"hi\"", "2"}},
+            {"\"\",x",                             {"", "x"}},
+            {"1,\"multi\nline\"",                  {"1", "multi\nline"}},
+            {string(63, 'x') + ",\"y,z\"",         {string(63, 'x'), "y,z"}},
+            {longQuoted + "," + longQuoted + ",1", {string(60, 'a') + ",\"" + string(10, 'b'),
+                                                    string(60, 'a') + ",\"" + string(10, 'b'), "1"}},
+            // Quotes within unquoted fields are ordinary bytes, including before and after a 64-byte boundary
+            {"5\" pipe,3",                         {"5\" pipe", "3"}},
+            {"ab\"c,\"d,e\",f\"",                  {"ab\"c", "d,e", "f\""}},
+            {string(70, 'x') + "\" pipe,3",        {string(70, 'x') + "\" pipe", "3"}},
+            {"5\" pipe," + longQuoted + ",a\"b,c", {"5\" pipe", string(60, 'a') + ",\"" + string(10, 'b'), "a\"b",
+                                                    "c"}},
+    };
+
+    for (const auto &target: targets) {
+        const string &record = get<0>(target);
+        vector<FieldBounds> bounds;
+        ASSERT_EQ(tokenizeRecord(record.data(), record.size(), ',', bounds), record.size());
+        ASSERT_EQ(bounds.size(), get<1>(target).size());
+        for (size_t i = 0; i < bounds.size(); i++) {
+            string field;
+            unescapeField(record.data(), bounds[i], field);
+            ASSERT_EQ(field, get<1>(target)[i]);
+        }
+    }
+
+    // A record ends at the first newline that is not within quotes
+    const string records = "a,\"b\nc\"\n" + string(100, 'd') + "\n";
+    vector<FieldBounds> bounds;
+    size_t consumed = tokenizeRecord(records.data(), records.size(), ',', bounds);
+    ASSERT_EQ(consumed, 8u);
+    ASSERT_EQ(bounds.size(), 2u);
+    bounds.clear();
+    ASSERT_EQ(tokenizeRecord(records.data() + consumed, records.size() - consumed, ',', bounds), 101u);
+    ASSERT_EQ(bounds.size(), 1u);
+    ASSERT_EQ(bounds[0].end - bounds[0].start, 100u);
+}
+
+
+TEST(Tokenizer, InferenceFromLinesIgnoresQuotes) {
+    // getDelim counts the delimiter within a quoted field, so the line with it is taken as the last line before the
+    // data rather than as a row of data
+    const vector<string> quotedDelimLines{"id,text", "1,\"a,b\"", "2,c", "3,d"};
+    const auto delimRet = getDelim(quotedDelimLines);
+    ASSERT_EQ(get<0>(delimRet), ',');
+    ASSERT_EQ(get<1>(delimRet), 2u);
+
+    // getFields tokenizes each line on its own, so a quoted field that spans lines is split into two rows
+    const vector<string> multiLineFieldLines{"id,text", "1,\"two", "lines\"", "2,c"};
+    vector<vector<string>> rows;
+    ASSERT_EQ(getFields(multiLineFieldLines, ',', rows), 0);
+    const vector<vector<string>> expectedRows{{"id", "text"}, {"1", "\"two"}, {"lines\""}, {"2", "c"}};
+    ASSERT_EQ(rows, expectedRows);
+}
+
+
+TEST_F(ClassificationTestFixture, ColumnarMatchesRows) {
+    auto parser = MpcParserTWrapper();
+
+    for (const auto &thisFileLines: filesLines) {
+        auto delimRet = getDelim(thisFileLines);
+        vector<vector<string>> fieldRet;
+        ColumnarFields columnarFieldRet;
+        ASSERT_TRUE(getFields(thisFileLines, get<0>(delimRet), fieldRet, get<1>(delimRet)));
+        ASSERT_TRUE(getFields(thisFileLines, get<0>(delimRet), columnarFieldRet, get<1>(delimRet)));
+
+        ASSERT_EQ(columnarFieldRet.getNumRows(), fieldRet.size());
+        ASSERT_EQ(columnarFieldRet.getNumColumns(), fieldRet.at(0).size());
+        for (size_t rowIdx = 0; rowIdx < fieldRet.size(); rowIdx++) {
+            ASSERT_EQ(columnarFieldRet.getNumFields(rowIdx), fieldRet.at(rowIdx).size());
+            for (size_t columnIdx = 0; columnIdx < fieldRet.at(rowIdx).size(); columnIdx++) {
+                ASSERT_EQ(columnarFieldRet.getField(rowIdx, columnIdx), fieldRet.at(rowIdx).at(columnIdx));
+            }
+        }
+
+        for (auto engine: {CE_MPC, CE_DFA}) {
+            vector<tuple<string, FieldCls>> classificationRet;
+            vector<tuple<string, FieldCls>> columnarClassificationRet;
+            size_t numSkippedParses;
+            size_t columnarNumSkippedParses;
+            classifyColumns(fieldRet, classificationRet, parser, &numSkippedParses, engine);
+            classifyColumns(columnarFieldRet, columnarClassificationRet, parser, &columnarNumSkippedParses, engine);
+            ASSERT_EQ(classificationRet, columnarClassificationRet);
+            ASSERT_EQ(numSkippedParses, columnarNumSkippedParses);
+        }
+    }
+}
+
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+TEST(ClassifyField, DoesNotGrowMemory) {
+    auto parser = MpcParserTWrapper();
+    vector<string> fileLines;
+    ASSERT_TRUE(FileReaderHelperTestFixture::getFileLines(R"(tests/test_targets/long_SEMS.dat)", fileLines));
+    auto delimRet = getDelim(fileLines);
+    vector<vector<string>> fieldRet;
+    ASSERT_TRUE(getFields(fileLines, get<0>(delimRet), fieldRet, get<1>(delimRet)));
+
+    for (auto engine: {CE_MPC, CE_DFA}) {
+        // Classify one field first so that one-time allocations (e.g., compiling the automaton) are not counted
+        classifyField(fieldRet.at(1).at(0), parser, engine);
+
+        const size_t allocatedBefore = mallinfo2().uordblks;
+        for (size_t rowIdx = 1; rowIdx < fieldRet.size(); rowIdx++) {
+            for (const auto &field: fieldRet.at(rowIdx)) {
+                classifyField(field, parser, engine);
+            }
+        }
+        ASSERT_EQ(mallinfo2().uordblks, allocatedBefore);
+    }
+}
+#endif